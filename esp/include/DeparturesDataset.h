@@ -0,0 +1,47 @@
+#ifndef __DEPARTURES_DATASET_H__
+#define __DEPARTURES_DATASET_H__
+
+#include <Arduino.h>
+#include <time.h>
+
+#include <DisplayApiClient.h>
+#include <Timetable.h>
+
+#ifndef DEPARTURES_MAX_SIZE
+#define DEPARTURES_MAX_SIZE 1024 // bytes of encoded dataset kept in RTC memory
+#endif
+
+#ifndef DEPARTURES_SYNC_PERIOD
+#define DEPARTURES_SYNC_PERIOD 900 // s, how often realtime delays are refreshed
+#endif
+
+#ifndef DEPARTURES_WINDOW
+#define DEPARTURES_WINDOW 30 // min of departures fetched per sync
+#endif
+
+#ifndef TIMETABLE_ROWS
+#define TIMETABLE_ROWS 4 // departures shown per stop
+#endif
+
+// Departures of the next DEPARTURES_WINDOW minutes, synced every
+// DEPARTURES_SYNC_PERIOD so the timetable can be rendered locally on the
+// wakes in between, with WiFi off. The dataset is kept in RTC memory in the
+// compact binary encoding of app/services/departures_encoding.py: interned,
+// length-prefixed strings and 6 bytes per departure.
+class DeparturesDataset
+{
+public:
+    static bool sync(DisplayApiClient &client, time_t now);
+    // True while the synced dataset still covers `now`.
+    static bool isFresh(time_t now);
+    // Fills `timetable` as it should look at `now`: departed entries are
+    // dropped and countdowns computed from the clock.
+    static bool load(Timetable &timetable, time_t now);
+    static time_t lastRendered();
+    static void markRendered(time_t now);
+    // Forgets what the panel shows, e.g. after it was cleared, so the next
+    // render draws the whole timetable.
+    static void invalidate();
+};
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef __TIMETABLE_H__
+#define __TIMETABLE_H__
+
+#include <Arduino.h>
+#include <time.h>
+
+#ifndef TIMETABLE_MAX_STOPS
+#define TIMETABLE_MAX_STOPS 8
+#endif
+
+#ifndef TIMETABLE_MAX_ENTRIES
+#define TIMETABLE_MAX_ENTRIES 64
+#endif
+
+#ifndef TIMETABLE_STRING_POOL_SIZE
+#define TIMETABLE_STRING_POOL_SIZE 1024 // bytes of interned names
+#endif
+
+#ifndef TIMETABLE_COUNTDOWN_MINUTES
+#define TIMETABLE_COUNTDOWN_MINUTES 10 // closer departures show minutes left
+#endif
+
+#define TIMETABLE_TIME_SIZE 12
+
+// Names are offsets into the string pool of their timetable.
+struct TimetableEntry
+{
+    uint8_t stop; // index into the stops of the timetable
+    uint16_t line;
+    uint16_t destination;
+    time_t departure; // delay included
+    int8_t delay;     // minutes
+    bool canceled;
+};
+
+struct TimetableStop
+{
+    uint16_t name;
+    uint16_t firstEntry;
+    uint16_t numEntries;
+};
+
+// Flat timetable: entries in one array sorted by (stop, departure), index
+// ranges per stop and a pool of interned names. Everything lives in fixed
+// inline storage and is released at once by reset(), so building one on
+// every wake never touches the heap.
+class Timetable
+{
+private:
+    char strings[TIMETABLE_STRING_POOL_SIZE];
+    uint16_t stringsUsed;
+    TimetableEntry entries[TIMETABLE_MAX_ENTRIES];
+    uint16_t numEntries;
+    TimetableStop stops[TIMETABLE_MAX_STOPS];
+    uint8_t numStops;
+    time_t referenceTime;
+    uint16_t changes;
+
+public:
+    static const uint16_t INVALID_STRING = UINT16_MAX;
+
+    Timetable();
+    void reset(time_t referenceTime);
+
+    // Offset of `text` in the pool, added unless an equal string is already
+    // there. INVALID_STRING when the pool is full.
+    uint16_t intern(const char *text, size_t length);
+    const char *string(uint16_t offset) const;
+
+    // Both return false when the timetable is full.
+    bool addStop(uint16_t name);
+    bool addEntry(uint8_t stop, uint16_t line, uint16_t destination, time_t departure, int8_t delay, bool canceled);
+    // Sorts the entries by (stop, departure) and rebuilds the stop ranges.
+    void sort();
+
+    uint8_t stopCount() const;
+    const TimetableStop &stop(uint8_t index) const;
+    const TimetableEntry &entry(uint16_t index) const;
+    bool empty() const;
+    // Changes whenever the timetable does, for layouts computed from it.
+    uint16_t revision() const;
+
+    // Scheduled time and delay, or a countdown for close departures, as of
+    // the reference time.
+    void formatTime(const TimetableEntry &entry, char *buffer, size_t size) const;
+};
+
+#endif
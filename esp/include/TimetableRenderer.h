@@ -1,28 +1,31 @@
 #ifndef __TIMETABLE_RENDERER_H__
 #define __TIMETABLE_RENDERER_H__
 
-#include <map>
-#include <vector>
 #include <Arduino.h>
 
 #include <Renderer.h>
+#include <Timetable.h>
 
-class TimetableEntry
+// Column positions and fitted destinations of one timetable in one set of
+// bounds. Computed once and reused for every page of every draw.
+struct TimetableLayout
 {
-private:
-    String lineNumber;
-    String destination;
-    String time;
-    String delay;
-public:
-    TimetableEntry(String lineNumber, String destination, String time, String delay);
-
-    String getFormattedDestination();
-    String getFormattedTime();
+    const Timetable *timetable;
+    uint16_t revision;
+    uint16_t x, y, w, h;
+    bool fits;
+    uint16_t padding;
+    int16_t lineX;
+    int16_t destinationX;
+    int16_t timeX;
+    uint16_t headerHeight;
+    uint16_t stopHeight;
+    uint16_t rowHeight;
+    uint16_t rowTextHeight;
+    uint8_t destinationLength[TIMETABLE_MAX_ENTRIES]; // bytes kept
+    bool destinationTruncated[TIMETABLE_MAX_ENTRIES];
 };
 
-typedef std::map<String, std::vector<TimetableEntry*>> timetable_t;
-
 class TimetableRenderer
 {
 private:
@@ -32,14 +35,27 @@ private:
     const uint8_t *tableFont = u8g2_font_helvR10_tf;
 
     Renderer &renderer;
-    timetable_t &timetable;
-
-    String getLongestStopName();
-    String getLongestDestinationName();
+    Timetable *timetable;
+    TimetableLayout layout = {};
+
+    const char *getLongestStopName();
+    const char *getLongestDestinationName();
+    void computeLayout(const Timetable &timetable, TimetableLayout &layout, uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+    // Recomputes the layout unless it is still valid for these bounds.
+    const TimetableLayout &getLayout(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+    // Bit per column (line, destination, time) whose cell differs between
+    // the rows of both timetables.
+    uint8_t diffRow(const Timetable &previous, const TimetableLayout &previousLayout, int16_t previousEntry, const TimetableLayout &layout, int16_t entry);
 
 public:
-    TimetableRenderer(Renderer &renderer, timetable_t &timetable);
+    TimetableRenderer(Renderer &renderer, Timetable &timetable);
     bool drawTimetable(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
-    void setTimetable(timetable_t &timetable);
+    void setTimetable(Timetable &timetable);
+    // Rectangles covering the cells that differ from `previous` drawn in the
+    // same bounds, adjacent cells merged. Returns how many were written, 0
+    // when nothing changed, or -1 when the layouts differ and the whole
+    // timetable has to be redrawn. When more than `capacity` are needed,
+    // their bounding box is the only one written.
+    int diff(const Timetable &previous, uint16_t x, uint16_t y, uint16_t w, uint16_t h, Bounds *windows, size_t capacity);
 };
-#endif
\ No newline at end of file
+#endif
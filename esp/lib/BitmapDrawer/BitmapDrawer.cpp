@@ -1,10 +1,21 @@
 #include <BitmapDrawer.h>
+#include <stdexcept>
+#ifdef ENABLE_JPEG_DECODER
+#include <JpegDrawer.h>
+#endif
 
 BitmapDrawer::BitmapDrawer(Reader &reader, Display &display) : reader(reader), display(display)
 {
     bmpHeader = new BMPHeader();
 }
 
+BitmapDrawer::~BitmapDrawer()
+{
+    delete ditherer;
+    delete[] rowPixels;
+    delete bmpHeader;
+}
+
 boolean BitmapDrawer::parseBMPHeader()
 {
     if (reader.getPos() != 0)
@@ -130,7 +141,7 @@ uint32_t BitmapDrawer::readRgb888Color()
             r = (msb & 0xF8);
             g = ((msb & 0x07) << 5) | ((lsb & 0xE0) >> 3);
             b = (lsb & 0x1F) << 3;
-            color = ((r << 8) | (g << 3) | (b >> 3));
+            color = ((r << 16) | (g << 8) | b);
         }
     }
     break;
@@ -197,55 +208,97 @@ size_t BitmapDrawer::getRowPos(size_t rowIndex)
     return bmpHeader->flip ? bmpHeader->imageOffset + (bmpHeader->height - rowIndex - 1) * bmpHeader->rowSize : bmpHeader->imageOffset + rowIndex * bmpHeader->rowSize;
 }
 
-void BitmapDrawer::drawRow(size_t rowIndex, int16_t x_offset, int16_t y_offset)
+void BitmapDrawer::drawRow(size_t rowIndex, size_t firstCol, size_t lastCol, int16_t x_offset, int16_t y_offset)
 {
-    const size_t rowStartPos = getRowPos(rowIndex);
-    const size_t rowEndPos = rowStartPos + bmpHeader->rowSize;
+    // Sub-byte pixels are read from the start of their byte.
+    const size_t pixelsPerByte = bmpHeader->depth < 8 ? 8 / bmpHeader->depth : 1;
+    const size_t startCol = firstCol - firstCol % pixelsPerByte;
+    const size_t rowStartPos = getRowPos(rowIndex) + startCol * bmpHeader->depth / 8;
+    const size_t rowEndPos = getRowPos(rowIndex) + bmpHeader->rowSize;
     if (reader.getPos() != rowStartPos)
     {
-        Serial.print("Warning, for row ");
-        Serial.print(rowIndex);
-        Serial.print(" expected to be at position ");
-        Serial.print(rowStartPos);
-        Serial.print(" but was at position ");
-        Serial.print(reader.getPos());
-        Serial.println(". Seeking to correct position");
+        if (startCol == 0)
+        {
+            Serial.print("Warning, for row ");
+            Serial.print(rowIndex);
+            Serial.print(" expected to be at position ");
+            Serial.print(rowStartPos);
+            Serial.print(" but was at position ");
+            Serial.print(reader.getPos());
+            Serial.println(". Seeking to correct position");
+        }
         reader.seek(rowStartPos);
     }
 
-    for (size_t colIndex = 0; colIndex < actualWidth; colIndex++)
+    for (size_t colIndex = startCol; colIndex <= lastCol; colIndex++)
     {
         uint32_t color;
         uint8_t currentByte;
         if (bmpHeader->depth > 8)
         {
             color = readRgb888Color();
+            if (ditherer != nullptr)
+            {
+                rowPixels[colIndex - firstCol] = rgb888ToRgb565(color);
+                continue;
+            }
         }
         else
         {
-            if (colIndex % (8 / bmpHeader->depth) == 0)
+            if (colIndex % pixelsPerByte == 0)
             {
                 currentByte = reader.read();
             }
+            if (colIndex < firstCol)
+            {
+                continue;
+            }
             color = readPaletteColor(currentByte, colIndex);
         }
-        display.drawPixel(colIndex + x_offset, rowIndex + y_offset, getColorToDraw(color));
+        rowPixels[colIndex - firstCol] = getColorToDraw(color);
+    }
+    if (ditherer != nullptr)
+    {
+        ditherer->drawRow(rowPixels, firstCol + x_offset, rowIndex + y_offset);
+    }
+    else
+    {
+        display.drawRow(firstCol + x_offset, rowIndex + y_offset, rowPixels, lastCol - firstCol + 1);
     }
 
-    while (reader.getPos() < rowEndPos)
+    // Whole rows are read through, so a stream never has to seek.
+    if (firstCol == 0 && lastCol == bmpHeader->width - 1)
     {
-        reader.read();
+        while (reader.getPos() < rowEndPos)
+        {
+            reader.read();
+        }
     }
 }
 
 void BitmapDrawer::drawBitmap(int16_t x_offset, int16_t y_offset)
+{
+    drawBitmap(SourceRect(), x_offset, y_offset);
+}
+
+void BitmapDrawer::drawBitmap(const SourceRect &crop, int16_t x, int16_t y)
 {
     uint32_t startTime = millis();
     Serial.println("Parsing header");
     parseBMPHeader();
 
-    actualWidth = min(bmpHeader->width, static_cast<uint32_t>(display.width() - x_offset));
-    actualHeight = min(bmpHeader->height, static_cast<int32_t>(display.height() - y_offset));
+    // Crop within the bitmap, then within the panel.
+    const uint32_t cropX = min<uint32_t>(crop.x, bmpHeader->width);
+    const uint32_t cropY = min<uint32_t>(crop.y, bmpHeader->height);
+    uint32_t cropWidth = bmpHeader->width - cropX;
+    uint32_t cropHeight = bmpHeader->height - cropY;
+    if (!crop.isEmpty())
+    {
+        cropWidth = min<uint32_t>(crop.width, cropWidth);
+        cropHeight = min<uint32_t>(crop.height, cropHeight);
+    }
+    actualWidth = min<int32_t>(cropWidth, display.width() - x);
+    actualHeight = min<int32_t>(cropHeight, display.height() - y);
     Serial.print("Actual width: ");
     Serial.println(actualWidth);
     Serial.print("Actual height: ");
@@ -254,53 +307,157 @@ void BitmapDrawer::drawBitmap(int16_t x_offset, int16_t y_offset)
     Serial.println("Parsing palette");
     parseColorPalette();
 
-    size_t pageStartRow = 0;
-    size_t pageEndRow;
-    size_t startPos;
+    rowPixels = new uint16_t[actualWidth];
+    // One ditherer for the frame, so its error carries over page seams.
+    if (bmpHeader->depth > 8)
+    {
+        ditherer = new PaletteDitherer(display, actualWidth, BITMAP_DITHER_MODE);
+    }
+    int32_t nextDitheredRow = -1;
+
+    // Bitmap column c is drawn at x_offset + c.
+    const int16_t x_offset = x - cropX;
+    const int16_t y_offset = y - cropY;
     do
     {
-        size_t pageHeight = display.getPageHeight();
-        pageEndRow = min(pageStartRow + pageHeight - 1, actualHeight - 1);
-        if (pageEndRow <= pageStartRow)
+        // Only the part of the crop under the current page is read. On a
+        // panel turned a quarter, pages are bands of columns and every row
+        // is read from the first column of the band.
+        int16_t pageX, pageY, pageWidth, pageHeight;
+        display.pageBounds(pageX, pageY, pageWidth, pageHeight);
+        const int32_t firstRow = max<int32_t>(pageY - y_offset, cropY);
+        const int32_t lastRow = min<int32_t>(pageY + pageHeight - y_offset, cropY + actualHeight) - 1;
+        int32_t firstCol = max<int32_t>(pageX - x_offset, cropX);
+        int32_t lastCol = min<int32_t>(pageX + pageWidth - x_offset, cropX + actualWidth) - 1;
+        if (firstRow > lastRow || firstCol > lastCol)
         {
             continue;
         }
-        // Serial.print("Drawing page ");
-        // Serial.print(display.curPage);
-        // Serial.print(" of height ");
-        // Serial.println(pageHeight);
-        // Serial.print("Starting row is ");
-        // Serial.print(pageStartRow);
-        // Serial.print(" and end row is ");
-        // Serial.println(pageEndRow);
+
+        if (ditherer != nullptr)
+        {
+            // Whole rows are dithered, so pages that are bands of columns
+            // all diffuse the same error. The error carries on when the
+            // rows of this page follow the ones of the previous page, and
+            // starts over otherwise: on column bands, every page then
+            // repeats the dither of the previous one exactly.
+            firstCol = cropX;
+            lastCol = cropX + actualWidth - 1;
+            if ((bmpHeader->flip ? lastRow : firstRow) != nextDitheredRow)
+            {
+                ditherer->reset();
+            }
+            nextDitheredRow = bmpHeader->flip ? firstRow - 1 : lastRow + 1;
+        }
+        // Rows are drawn in file order, bottom-up bitmaps from the last row.
         if (bmpHeader->flip)
         {
-            Serial.print("Seeking to ");
-            Serial.println(pageEndRow);
-            reader.seek(getRowPos(pageEndRow));
-            Serial.println("Start drawing.");
-            for (size_t rowIndex = pageEndRow; rowIndex > pageStartRow; rowIndex--)
+            for (int32_t rowIndex = lastRow; rowIndex >= firstRow; rowIndex--)
             {
-                drawRow(rowIndex, x_offset, y_offset);
+                drawRow(rowIndex, firstCol, lastCol, x_offset, y_offset);
             }
-            drawRow(pageStartRow, x_offset, y_offset);
         }
         else
         {
-            reader.seek(getRowPos(pageStartRow));
-            for (size_t rowIndex = pageStartRow; rowIndex <= pageEndRow; rowIndex++)
+            for (int32_t rowIndex = firstRow; rowIndex <= lastRow; rowIndex++)
             {
-                drawRow(rowIndex, x_offset, y_offset);
+                drawRow(rowIndex, firstCol, lastCol, x_offset, y_offset);
             }
         }
-
-        pageStartRow += pageHeight;
-    } while (display.nextPage());
+        display.flushRows();
+    } while (allPages && display.nextPage());
+    delete ditherer;
+    ditherer = nullptr;
+    delete[] rowPixels;
+    rowPixels = nullptr;
     Serial.print("Bitmap loaded in ");
     Serial.print(millis() - startTime);
     Serial.println(" ms");
 }
 
+FrameFormat BitmapDrawer::sniffFormat()
+{
+    uint16_t signature = reader.read16();
+    reader.seek(0);
+    switch (signature)
+    {
+    case 0x4D42: // "BM"
+        return FrameFormat::BMP;
+    case 0xD8FF: // start of image marker
+        return FrameFormat::JPEG;
+    default:
+        return FrameFormat::UNKNOWN;
+    }
+}
+
+void BitmapDrawer::draw(const char *format, int16_t x_offset, int16_t y_offset)
+{
+    draw(format, SourceRect(), x_offset, y_offset);
+}
+
+void BitmapDrawer::draw(const char *format, const SourceRect &crop, int16_t x, int16_t y)
+{
+    FrameFormat frameFormat = parseFrameFormat(format);
+    if (frameFormat == FrameFormat::UNKNOWN)
+    {
+        frameFormat = sniffFormat();
+    }
+    switch (frameFormat)
+    {
+    case FrameFormat::BMP:
+        drawBitmap(crop, x, y);
+        break;
+#ifdef ENABLE_JPEG_DECODER
+    case FrameFormat::JPEG:
+    {
+        // The whole image is decoded anyway, so it is shifted by the crop
+        // and the window drops what falls outside of it.
+        JpegDrawer jpegDrawer(reader, display);
+        jpegDrawer.drawJpeg(x - crop.x, y - crop.y, allPages);
+        break;
+    }
+#endif
+    default:
+        Serial.print("No decoder for frame format ");
+        Serial.println(format != nullptr ? format : "");
+        throw std::runtime_error("Unsupported frame format");
+    }
+}
+
+void BitmapDrawer::drawPage(const char *format, const SourceRect &crop, int16_t x, int16_t y)
+{
+    // The previous page left the reader past the header.
+    reader.seek(0);
+    allPages = false;
+    try
+    {
+        draw(format, crop, x, y);
+    }
+    catch (...)
+    {
+        allPages = true;
+        throw;
+    }
+    allPages = true;
+}
+
+FrameFormat parseFrameFormat(const char *name)
+{
+    if (name == nullptr)
+    {
+        return FrameFormat::UNKNOWN;
+    }
+    if (strcmp(name, "bmp") == 0 || strcmp(name, "image/bmp") == 0)
+    {
+        return FrameFormat::BMP;
+    }
+    if (strcmp(name, "jpeg") == 0 || strcmp(name, "image/jpeg") == 0)
+    {
+        return FrameFormat::JPEG;
+    }
+    return FrameFormat::UNKNOWN;
+}
+
 uint16_t rgb888ToRgb565(uint32_t rgb888)
 {
     uint8_t r = (rgb888 >> 16) & 0xFF;
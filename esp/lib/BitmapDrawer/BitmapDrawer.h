@@ -2,8 +2,43 @@
 #define BITMAP_DRAWER_H
 
 #include <Display.h>
+#include <PaletteDitherer.h>
 #include <Reader.h>
 
+// How 16/24/32-bit bitmaps are reduced to the panel palette. Palette-based
+// bitmaps are drawn as they are, the server already dithered them.
+#ifndef BITMAP_DITHER_MODE
+#define BITMAP_DITHER_MODE DitherMode::DIFFUSION
+#endif
+
+// Frame formats with a decoder in this build, advertised to the server.
+#ifdef ENABLE_JPEG_DECODER
+#define FRAME_DECODERS "bmp,jpeg"
+#else
+#define FRAME_DECODERS "bmp"
+#endif
+
+enum class FrameFormat
+{
+    UNKNOWN,
+    BMP,
+    JPEG
+};
+
+// FrameFormat of a manifest format name or media type, UNKNOWN when empty.
+FrameFormat parseFrameFormat(const char *name);
+
+// Part of a frame to draw, the whole frame when width or height is 0.
+struct SourceRect
+{
+    uint32_t x = 0;
+    uint32_t y = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    bool isEmpty() const { return width == 0 || height == 0; }
+};
+
 struct BMPHeader
 {
     uint32_t fileSize;
@@ -29,6 +64,9 @@ private:
     size_t actualHeight = 0;
     size_t actualWidth = 0;
     uint32_t colorPalette[max_palette_pixels];
+    PaletteDitherer *ditherer = nullptr;
+    uint16_t *rowPixels = nullptr; // RGB565 row handed to the ditherer, or the panel colors of a palette row
+    bool allPages = true;          // false while drawing a single page
 
     boolean parseBMPHeader();
     boolean parseColorPalette();
@@ -36,11 +74,24 @@ private:
     uint32_t readPaletteColor(uint8_t currentByte, size_t index);
     uint16_t getColorToDraw(uint32_t rgb888, boolean withColor = true);
     size_t getRowPos(size_t rowIndex);
-    void drawRow(size_t rowIndex, int16_t x_offset, int16_t y_offset);
+    void drawRow(size_t rowIndex, size_t firstCol, size_t lastCol, int16_t x_offset, int16_t y_offset);
+    FrameFormat sniffFormat();
 
 public:
     BitmapDrawer(Reader &reader, Display &display);
+    ~BitmapDrawer();
     void drawBitmap(int16_t x_offset = 0, int16_t y_offset = 0);
+    // Draws the `crop` of the bitmap with its top left corner at (x, y).
+    // Rows above and below the crop are skipped with seeks, which readers
+    // over HTTP turn into Range requests.
+    void drawBitmap(const SourceRect &crop, int16_t x, int16_t y);
+    // Draws the frame with the decoder for `format`, as announced by the
+    // server, or for its leading bytes when the format is not known.
+    void draw(const char *format, int16_t x_offset = 0, int16_t y_offset = 0);
+    void draw(const char *format, const SourceRect &crop, int16_t x, int16_t y);
+    // Draws the part of the frame under the current page and leaves moving to
+    // the next one to the caller, so several frames can share a page loop.
+    void drawPage(const char *format, const SourceRect &crop, int16_t x, int16_t y);
 };
 
 uint16_t rgb888ToRgb565(uint32_t rgb888);
@@ -0,0 +1,17 @@
+#include <DeviceCapabilities.h>
+#include <BitmapDrawer.h>
+
+#define CAPABILITIES_STRING(x) #x
+#define CAPABILITIES_EXPAND(x) CAPABILITIES_STRING(x)
+
+const char *deviceCapabilities()
+{
+    static char capabilities[160] = "";
+    if (capabilities[0] == '\0')
+    {
+        snprintf(capabilities, sizeof(capabilities), "formats=%s; panel=%s; driver=%s; size=%ux%u; palette=%s",
+                 FRAME_DECODERS, PANEL_TYPE, CAPABILITIES_EXPAND(GxEPD2_DRIVER_CLASS),
+                 (unsigned)GxEPD2_DRIVER_CLASS::WIDTH, (unsigned)GxEPD2_DRIVER_CLASS::HEIGHT, PANEL_PALETTE);
+    }
+    return capabilities;
+}
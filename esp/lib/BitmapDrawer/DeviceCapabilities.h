@@ -0,0 +1,23 @@
+#ifndef DEVICE_CAPABILITIES_H
+#define DEVICE_CAPABILITIES_H
+
+#include <Display.h>
+
+#define DEVICE_CAPABILITIES_HEADER "X-Display-Capabilities"
+
+#if defined(DISP_7C)
+#define PANEL_TYPE "7c"
+#define PANEL_PALETTE "000000,ffffff,00ff00,0000ff,ff0000,ffff00,ff8000"
+#elif defined(DISP_3C)
+#define PANEL_TYPE "3c"
+#ifndef PANEL_PALETTE
+#define PANEL_PALETTE "000000,ffffff,ff0000" // red panels, override for yellow ones
+#endif
+#endif
+
+// What this build can draw, sent with every request so the server can pick
+// the cheapest frame format for the device, e.g.
+// "formats=bmp; panel=3c; driver=GxEPD2_750c_GDEY075Z08; size=800x480; palette=000000,ffffff,ff0000"
+const char *deviceCapabilities();
+
+#endif // DEVICE_CAPABILITIES_H
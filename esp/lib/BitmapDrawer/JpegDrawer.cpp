@@ -0,0 +1,150 @@
+#include <JpegDrawer.h>
+
+#ifdef ENABLE_JPEG_DECODER
+#include <stdexcept>
+
+JpegDrawer::JpegDrawer(Reader &reader, Display &display)
+    : reader(reader), display(display), decoder(nullptr), ditherer(nullptr), band(nullptr), bandWidth(0), bandHeight(0), bandY(-1), imageHeight(0), pageBottom(0), pastPage(false), x_offset(0), y_offset(0)
+{
+}
+
+JpegDrawer::~JpegDrawer()
+{
+    delete decoder;
+    delete ditherer;
+    delete[] band;
+}
+
+int32_t JpegDrawer::readCallback(JPEGFILE *file, uint8_t *buffer, int32_t length)
+{
+    Reader *reader = static_cast<Reader *>(file->fHandle);
+    if (file->iSize > 0 && file->iPos + length > file->iSize)
+    {
+        length = file->iSize - file->iPos;
+    }
+    int32_t read = reader->readBytes(buffer, length);
+    file->iPos = reader->getPos();
+    return read;
+}
+
+int32_t JpegDrawer::seekCallback(JPEGFILE *file, int32_t position)
+{
+    Reader *reader = static_cast<Reader *>(file->fHandle);
+    if (!reader->seek(position))
+    {
+        return -1;
+    }
+    file->iPos = position;
+    return position;
+}
+
+int JpegDrawer::drawCallback(JPEGDRAW *draw)
+{
+    JpegDrawer *drawer = static_cast<JpegDrawer *>(draw->pUser);
+    if (draw->y != drawer->bandY)
+    {
+        drawer->flushBand();
+        if (draw->y >= drawer->pageBottom)
+        {
+            // Rows come top to bottom, the rest of the image is off the page.
+            drawer->pastPage = true;
+            return 0;
+        }
+        drawer->bandY = draw->y;
+        drawer->bandHeight = min<int>(draw->iHeight, JPEG_MAX_MCU_HEIGHT);
+    }
+    if (draw->x >= drawer->bandWidth)
+    {
+        return 1;
+    }
+    // MCUs on the right edge may be padded past the image.
+    uint16_t width = min<int>(draw->iWidth, drawer->bandWidth - draw->x);
+    for (uint16_t row = 0; row < drawer->bandHeight; row++)
+    {
+        memcpy(drawer->band + row * drawer->bandWidth + draw->x, draw->pPixels + row * draw->iWidth, width * sizeof(uint16_t));
+    }
+    return 1;
+}
+
+void JpegDrawer::flushBand()
+{
+    if (bandY < 0)
+    {
+        return;
+    }
+    for (uint16_t row = 0; row < bandHeight && bandY + row < imageHeight; row++)
+    {
+        ditherer->drawRow(band + row * bandWidth, x_offset, y_offset + bandY + row);
+    }
+    bandY = -1;
+}
+
+void JpegDrawer::open()
+{
+    if (!decoder->open(&reader, reader.getSize(), nullptr, readCallback, seekCallback, drawCallback))
+    {
+        Serial.print("Could not open JPEG: ");
+        Serial.println(decoder->getLastError());
+        throw std::runtime_error("Could not open JPEG");
+    }
+    decoder->setPixelType(RGB565_LITTLE_ENDIAN);
+    decoder->setUserPointer(this);
+}
+
+void JpegDrawer::drawJpeg(int16_t x_offset, int16_t y_offset, bool allPages)
+{
+    uint32_t startTime = millis();
+    if (reader.getSize() == 0)
+    {
+        throw std::runtime_error("JPEG frames need a known size");
+    }
+    this->x_offset = x_offset;
+    this->y_offset = y_offset;
+    decoder = new JPEGDEC();
+    open();
+    bandWidth = min<int>(decoder->getWidth(), display.width() - x_offset);
+    imageHeight = min<int>(decoder->getHeight(), display.height() - y_offset);
+    Serial.print("JPEG of ");
+    Serial.print(decoder->getWidth());
+    Serial.print("x");
+    Serial.println(decoder->getHeight());
+    band = new uint16_t[bandWidth * JPEG_MAX_MCU_HEIGHT];
+
+    ditherer = new PaletteDitherer(display, bandWidth);
+    bool firstPage = true;
+    do
+    {
+        // A single page takes one decode. With more, every page decodes
+        // from the top, the error diffused over the rows above it so seams
+        // match, and stops past its bottom.
+        if (!firstPage)
+        {
+            reader.seek(0);
+            open();
+            ditherer->reset();
+        }
+        firstPage = false;
+        int16_t pageX, pageY, pageWidth, pageHeight;
+        display.pageBounds(pageX, pageY, pageWidth, pageHeight);
+        pageBottom = pageY + pageHeight - y_offset;
+        pastPage = false;
+        int decoded = decoder->decode(0, 0, 0);
+        flushBand();
+        display.flushRows();
+        decoder->close();
+        if (!decoded && !pastPage)
+        {
+            Serial.print("JPEG decode failed: ");
+            Serial.println(decoder->getLastError());
+            throw std::runtime_error("JPEG decode failed");
+        }
+    } while (allPages && display.nextPage());
+    delete ditherer;
+    ditherer = nullptr;
+
+    Serial.print("JPEG decoded in ");
+    Serial.print(millis() - startTime);
+    Serial.println(" ms");
+}
+
+#endif // ENABLE_JPEG_DECODER
@@ -0,0 +1,49 @@
+#ifndef JPEG_DRAWER_H
+#define JPEG_DRAWER_H
+
+#ifdef ENABLE_JPEG_DECODER
+
+#include <Display.h>
+#include <Reader.h>
+#include <JPEGDEC.h>
+
+#include "PaletteDitherer.h"
+
+#define JPEG_MAX_MCU_HEIGHT 16
+
+// Decodes a baseline JPEG streamed from a Reader one MCU row at a time and
+// dithers it onto the panel palette. Only one row of MCUs is buffered, so
+// memory stays at about 32 bytes per column whatever the image height.
+class JpegDrawer
+{
+private:
+    Reader &reader;
+    Display &display;
+    JPEGDEC *decoder;
+    PaletteDitherer *ditherer;
+    uint16_t *band; // RGB565, bandWidth x JPEG_MAX_MCU_HEIGHT
+    uint16_t bandWidth;
+    uint16_t bandHeight;
+    int16_t bandY;
+    uint16_t imageHeight;
+    int16_t pageBottom; // image row past the current page, decoding stops there
+    bool pastPage;
+    int16_t x_offset;
+    int16_t y_offset;
+
+    static int32_t readCallback(JPEGFILE *file, uint8_t *buffer, int32_t length);
+    static int32_t seekCallback(JPEGFILE *file, int32_t position);
+    static int drawCallback(JPEGDRAW *draw);
+    void open();
+    void flushBand();
+
+public:
+    JpegDrawer(Reader &reader, Display &display);
+    ~JpegDrawer();
+    // Draws every page, or only the current one when `allPages` is false.
+    void drawJpeg(int16_t x_offset = 0, int16_t y_offset = 0, bool allPages = true);
+};
+
+#endif // ENABLE_JPEG_DECODER
+
+#endif // JPEG_DRAWER_H
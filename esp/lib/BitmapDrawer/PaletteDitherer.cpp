@@ -0,0 +1,152 @@
+#include <PaletteDitherer.h>
+
+// Same colors as the server's epd_palette.
+static const PaletteColor sevenColorPalette[] = {
+    {0, 0, 0, GxEPD_BLACK},
+    {255, 255, 255, GxEPD_WHITE},
+    {0, 255, 0, GxEPD_GREEN},
+    {0, 0, 255, GxEPD_BLUE},
+    {255, 0, 0, GxEPD_RED},
+    {255, 255, 0, GxEPD_YELLOW},
+    {255, 128, 0, GxEPD_ORANGE},
+};
+
+static const PaletteColor threeColorPalette[] = {
+    {0, 0, 0, GxEPD_BLACK},
+    {255, 255, 255, GxEPD_WHITE},
+    {255, 0, 0, GxEPD_COLORED},
+};
+
+// 4x4 Bayer matrix, thresholds 0..15.
+static const uint8_t bayer[4][4] = {
+    {0, 8, 2, 10},
+    {12, 4, 14, 6},
+    {3, 11, 1, 9},
+    {15, 7, 13, 5},
+};
+
+const PaletteColor *PaletteDitherer::nearestPalette = nullptr;
+uint8_t PaletteDitherer::nearest[1 << (3 * DITHER_LUT_BITS)];
+
+static inline int16_t clampChannel(int16_t value)
+{
+    return value < 0 ? 0 : value > 255 ? 255 : value;
+}
+
+PaletteDitherer::PaletteDitherer(Display &display, uint16_t width, DitherMode mode)
+    : display(display), mode(mode), width(width), currentErrors(nullptr), nextErrors(nullptr), colors(new uint16_t[width])
+{
+    if (display.hasMultiColors)
+    {
+        palette = sevenColorPalette;
+        numColors = sizeof(sevenColorPalette) / sizeof(sevenColorPalette[0]);
+    }
+    else
+    {
+        palette = threeColorPalette;
+        numColors = sizeof(threeColorPalette) / sizeof(threeColorPalette[0]);
+    }
+    if (mode == DitherMode::DIFFUSION)
+    {
+        currentErrors = new int16_t[(width + 2) * 3]();
+        nextErrors = new int16_t[(width + 2) * 3]();
+    }
+
+    if (nearestPalette == palette)
+    {
+        return;
+    }
+    // Nearest color of the center of every cell of the quantized RGB cube.
+    nearestPalette = palette;
+    const uint8_t levels = 1 << DITHER_LUT_BITS;
+    const uint8_t shift = 8 - DITHER_LUT_BITS;
+    for (uint16_t i = 0; i < sizeof(nearest); i++)
+    {
+        int16_t r = ((i / (levels * levels)) << shift) + (1 << (shift - 1));
+        int16_t g = (((i / levels) % levels) << shift) + (1 << (shift - 1));
+        int16_t b = ((i % levels) << shift) + (1 << (shift - 1));
+        uint32_t bestDistance = UINT32_MAX;
+        for (uint8_t c = 0; c < numColors; c++)
+        {
+            int32_t dr = r - palette[c].r;
+            int32_t dg = g - palette[c].g;
+            int32_t db = b - palette[c].b;
+            uint32_t distance = dr * dr + dg * dg + db * db;
+            if (distance < bestDistance)
+            {
+                bestDistance = distance;
+                nearest[i] = c;
+            }
+        }
+    }
+}
+
+PaletteDitherer::~PaletteDitherer()
+{
+    delete[] currentErrors;
+    delete[] nextErrors;
+    delete[] colors;
+}
+
+void PaletteDitherer::reset()
+{
+    if (mode == DitherMode::DIFFUSION)
+    {
+        memset(currentErrors, 0, (width + 2) * 3 * sizeof(int16_t));
+        memset(nextErrors, 0, (width + 2) * 3 * sizeof(int16_t));
+    }
+}
+
+uint8_t PaletteDitherer::findNearest(int16_t r, int16_t g, int16_t b)
+{
+    const uint8_t shift = 8 - DITHER_LUT_BITS;
+    return nearest[((r >> shift) << (2 * DITHER_LUT_BITS)) | ((g >> shift) << DITHER_LUT_BITS) | (b >> shift)];
+}
+
+void PaletteDitherer::drawRow(const uint16_t *pixels, int16_t x, int16_t y)
+{
+    if (mode != DitherMode::DIFFUSION)
+    {
+        // Every palette channel is either 0 or 255 (orange aside), so the
+        // threshold spans the whole channel range.
+        const uint8_t *thresholds = bayer[y & 3];
+        for (uint16_t i = 0; i < width; i++)
+        {
+            uint16_t pixel = pixels[i];
+            int16_t offset = mode == DitherMode::ORDERED ? thresholds[(x + i) & 3] * 16 - 120 : 0;
+            int16_t r = clampChannel((((pixel >> 8) & 0xF8) | (pixel >> 13)) + offset);
+            int16_t g = clampChannel((((pixel >> 3) & 0xFC) | ((pixel >> 9) & 0x03)) + offset);
+            int16_t b = clampChannel((((pixel << 3) & 0xF8) | ((pixel >> 2) & 0x07)) + offset);
+            colors[i] = palette[findNearest(r, g, b)].color;
+        }
+        display.drawRow(x, y, colors, width);
+        return;
+    }
+    for (uint16_t i = 0; i < width; i++)
+    {
+        uint16_t pixel = pixels[i];
+        int16_t *error = currentErrors + (i + 1) * 3;
+        // Errors are kept in 1/16ths, the Floyd-Steinberg denominator.
+        int16_t r = clampChannel((((pixel >> 8) & 0xF8) | (pixel >> 13)) + error[0] / 16);
+        int16_t g = clampChannel((((pixel >> 3) & 0xFC) | ((pixel >> 9) & 0x03)) + error[1] / 16);
+        int16_t b = clampChannel((((pixel << 3) & 0xF8) | ((pixel >> 2) & 0x07)) + error[2] / 16);
+        const PaletteColor &color = palette[findNearest(r, g, b)];
+        colors[i] = color.color;
+
+        const int16_t diffs[3] = {(int16_t)(r - color.r), (int16_t)(g - color.g), (int16_t)(b - color.b)};
+        int16_t *below = nextErrors + (i + 1) * 3;
+        for (uint8_t c = 0; c < 3; c++)
+        {
+            error[3 + c] += diffs[c] * 7;
+            below[c - 3] += diffs[c] * 3;
+            below[c] += diffs[c] * 5;
+            below[3 + c] += diffs[c];
+        }
+    }
+    display.drawRow(x, y, colors, width);
+    // The next row becomes the current one, with fresh errors after it.
+    int16_t *swap = currentErrors;
+    currentErrors = nextErrors;
+    nextErrors = swap;
+    memset(nextErrors, 0, (width + 2) * 3 * sizeof(int16_t));
+}
@@ -0,0 +1,56 @@
+#ifndef PALETTE_DITHERER_H
+#define PALETTE_DITHERER_H
+
+#include <Display.h>
+
+#define DITHER_LUT_BITS 4 // per channel, the nearest-color table has 2^(3*bits) entries
+
+enum class DitherMode
+{
+    NONE,     // nearest palette color
+    ORDERED,  // 4x4 Bayer threshold, rows in any order
+    DIFFUSION // Floyd-Steinberg, rows top to bottom
+};
+
+struct PaletteColor
+{
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+    uint16_t color; // GxEPD color drawn for it
+};
+
+// Dithers RGB rows onto the panel palette, either with a Bayer threshold
+// map or with Floyd-Steinberg error diffusion. Diffusion only keeps the
+// errors of the current and the next row, and the nearest palette color
+// comes from a table computed once, so rows can be dithered as a decoder
+// streams them out.
+class PaletteDitherer
+{
+private:
+    Display &display;
+    const PaletteColor *palette;
+    uint8_t numColors;
+    DitherMode mode;
+    uint16_t width;
+    int16_t *currentErrors; // (width + 2) * 3, one pixel of margin each side
+    int16_t *nextErrors;
+    uint16_t *colors; // the dithered row, drawn in one go
+    // Built for the first ditherer of a palette, kept for the next ones.
+    static const PaletteColor *nearestPalette;
+    static uint8_t nearest[1 << (3 * DITHER_LUT_BITS)];
+
+    uint8_t findNearest(int16_t r, int16_t g, int16_t b);
+
+public:
+    PaletteDitherer(Display &display, uint16_t width, DitherMode mode = DitherMode::DIFFUSION);
+    ~PaletteDitherer();
+    // Dithers `width` RGB565 pixels and draws them at (x, y). With
+    // DIFFUSION, the error is pushed to the row drawn next, so rows should
+    // come in order, top to bottom or bottom to top.
+    void drawRow(const uint16_t *pixels, int16_t x, int16_t y);
+    // Drops the diffused error, for rows that start over from the top.
+    void reset();
+};
+
+#endif // PALETTE_DITHERER_H
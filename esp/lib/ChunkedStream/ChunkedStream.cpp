@@ -0,0 +1,135 @@
+#include "ChunkedStream.h"
+
+ChunkedStream::ChunkedStream(Stream &stream, bool chunked)
+    : stream(stream), chunked(chunked), done(false), remaining(0) {}
+
+// One byte of the socket, waiting up to the timeout of the underlying stream.
+int ChunkedStream::next()
+{
+    uint8_t c;
+    return stream.readBytes(&c, 1) == 1 ? c : -1;
+}
+
+// Reads the size line of the next chunk, and the trailers after the last
+// one. False at the end of the body or when it is malformed.
+bool ChunkedStream::startChunk()
+{
+    if (done)
+    {
+        return false;
+    }
+    if (remaining > 0)
+    {
+        return true;
+    }
+    size_t size = 0;
+    bool hasSize = false;
+    bool inSize = true;
+    int c;
+    while ((c = next()) >= 0 && c != '\n')
+    {
+        int digit = c >= '0' && c <= '9'   ? c - '0'
+                    : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                    : c >= 'A' && c <= 'F' ? c - 'A' + 10
+                                           : -1;
+        // Chunk extensions after the size are ignored.
+        if (inSize && digit >= 0)
+        {
+            size = size * 16 + digit;
+            hasSize = true;
+        }
+        else
+        {
+            inSize = false;
+        }
+    }
+    if (c < 0 || !hasSize)
+    {
+        done = true;
+        return false;
+    }
+    if (size == 0)
+    {
+        // Trailers, up to the empty line ending the body.
+        size_t lineLength = 0;
+        while ((c = next()) >= 0)
+        {
+            if (c == '\n')
+            {
+                if (lineLength == 0)
+                {
+                    break;
+                }
+                lineLength = 0;
+            }
+            else if (c != '\r')
+            {
+                lineLength++;
+            }
+        }
+        done = true;
+        return false;
+    }
+    remaining = size;
+    return true;
+}
+
+int ChunkedStream::available()
+{
+    if (!chunked)
+    {
+        return stream.available();
+    }
+    int available = stream.available();
+    return done || available < 0 ? 0 : min<size_t>(available, remaining);
+}
+
+int ChunkedStream::read()
+{
+    if (!chunked)
+    {
+        return stream.read();
+    }
+    if (!startChunk())
+    {
+        return -1;
+    }
+    int c = next();
+    if (c < 0)
+    {
+        done = true;
+        return -1;
+    }
+    if (--remaining == 0)
+    {
+        // CRLF closing the chunk data.
+        next();
+        next();
+    }
+    return c;
+}
+
+int ChunkedStream::peek()
+{
+    if (!chunked)
+    {
+        return stream.peek();
+    }
+    return startChunk() ? stream.peek() : -1;
+}
+
+size_t ChunkedStream::write(uint8_t)
+{
+    return 0;
+}
+
+void ChunkedStream::finish()
+{
+    if (!chunked)
+    {
+        return;
+    }
+    while (read() >= 0)
+    {
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef CHUNKED_STREAM_H
+#define CHUNKED_STREAM_H
+
+#include <Arduino.h>
+
+// Body of an HTTP/1.1 response read from the socket, with the chunked
+// transfer coding removed so ArduinoJson can parse it in place and the
+// connection stays open for the next request. A body that is not chunked is
+// passed through as is.
+class ChunkedStream : public Stream
+{
+private:
+    Stream &stream;
+    bool chunked;
+    bool done;
+    size_t remaining; // bytes left in the current chunk
+
+    int next();
+    bool startChunk();
+
+public:
+    ChunkedStream(Stream &stream, bool chunked);
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t) override;
+    // Reads up to the last chunk, so the next response on the connection
+    // starts at its status line.
+    void finish();
+};
+
+#endif // CHUNKED_STREAM_H
@@ -1,8 +1,92 @@
 #include <Display.h>
-#include <Reader.h>
 
-Display::Display() : curPage(0)
+// GxEPD2 keeps its page buffer and partial window private. An explicit
+// instantiation may name private members, so PanelMember hands out member
+// pointers to them. verifyBuffer() checks the layout against GxEPD2's own
+// drawPixel() before anything is written through them.
+template <typename Tag, typename Tag::type Member>
+struct PanelMember
 {
+  friend typename Tag::type get(Tag)
+  {
+    return Member;
+  }
+};
+
+#define PANEL_MEMBER(NAME, TYPE)                     \
+  struct NAME##Tag                                   \
+  {                                                  \
+    typedef TYPE Display::Panel::*type;              \
+    friend type get(NAME##Tag);                      \
+  };                                                 \
+  template struct PanelMember<NAME##Tag, &Display::Panel::NAME>
+
+#if defined(DISP_7C)
+typedef uint8_t PanelPlane[(GxEPD2_DRIVER_CLASS::WIDTH / 2) * MAX_HEIGHT(GxEPD2_DRIVER_CLASS)];
+PANEL_MEMBER(_buffer, PanelPlane);
+#else
+typedef uint8_t PanelPlane[(GxEPD2_DRIVER_CLASS::WIDTH / 8) * MAX_HEIGHT(GxEPD2_DRIVER_CLASS)];
+PANEL_MEMBER(_black_buffer, PanelPlane);
+PANEL_MEMBER(_color_buffer, PanelPlane);
+#endif
+PANEL_MEMBER(_pw_x, uint16_t);
+PANEL_MEMBER(_pw_y, uint16_t);
+PANEL_MEMBER(_pw_w, uint16_t);
+PANEL_MEMBER(_pw_h, uint16_t);
+
+static uint8_t *plane(Display::Panel &panel, uint8_t index)
+{
+#if defined(DISP_7C)
+  return panel.*get(_bufferTag());
+#else
+  return index == 0 ? panel.*get(_black_bufferTag()) : panel.*get(_color_bufferTag());
+#endif
+}
+
+// Bits of the pixel in column `bx` of the buffer within its byte.
+static inline uint8_t pixelMask(int16_t bx)
+{
+#if defined(DISP_7C)
+  return bx % 2 ? 0x0F : 0xF0;
+#else
+  return 0x80 >> (bx % 8);
+#endif
+}
+
+// Transposes a tile of DISPLAY_PIXELS_PER_BYTE bytes, byte i holding row i
+// with its first pixel in the high bits, so byte j of `out` holds column j.
+static inline void transposeTile(const uint8_t *in, uint8_t *out)
+{
+#if defined(DISP_7C)
+  out[0] = (in[0] & 0xF0) | (in[1] >> 4);
+  out[1] = (in[0] << 4) | (in[1] & 0x0F);
+#else
+  // 8x8 bit matrix, as in Hacker's Delight.
+  uint32_t x = (uint32_t)in[0] << 24 | (uint32_t)in[1] << 16 | (uint32_t)in[2] << 8 | in[3];
+  uint32_t y = (uint32_t)in[4] << 24 | (uint32_t)in[5] << 16 | (uint32_t)in[6] << 8 | in[7];
+  uint32_t t = (x ^ (x >> 7)) & 0x00AA00AA;
+  x = x ^ t ^ (t << 7);
+  t = (y ^ (y >> 7)) & 0x00AA00AA;
+  y = y ^ t ^ (t << 7);
+  t = (x ^ (x >> 14)) & 0x0000CCCC;
+  x = x ^ t ^ (t << 14);
+  t = (y ^ (y >> 14)) & 0x0000CCCC;
+  y = y ^ t ^ (t << 14);
+  t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+  y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+  x = t;
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    out[i] = x >> (24 - 8 * i);
+    out[4 + i] = y >> (24 - 8 * i);
+  }
+#endif
+}
+
+Display::Display() : asyncRefresh(false), refreshDone(nullptr), directAccess(false), numNativeColors(0), lastColor(0), stripColumn(-1), stripFirst(0), stripLast(0),
+                     curPage(0), rotation(DISPLAY_ROTATION), windowY(0), windowHeight(GxEPD2_DRIVER_CLASS::HEIGHT)
+{
+  memset(strip, 0, sizeof(strip));
   hasMultiColors = ((display.epd2.panel == GxEPD2::ACeP730) || display.epd2.panel == GxEPD2::ACeP565) || (display.epd2.panel == GxEPD2::GDEY073D46) || (display.epd2.panel == GxEPD2::GDEM037F51);
 }
 
@@ -11,34 +95,562 @@ void Display::initDisplay()
   display.init(115200, true, 10, false);
   //display.init(115200, true, 2, false);
   reset();
+  directAccess = verifyBuffer();
+  if (!directAccess)
+  {
+    Serial.println("Page buffer layout not recognized, drawing pixel by pixel");
+  }
+  reset();
   return;
 }
 
 void Display::reset()
 {
+  waitForRefresh();
   curPage = 0;
-  display.setRotation(0);
+  display.setRotation(rotation);
   display.setTextSize(1);
   display.setTextColor(GxEPD_BLACK);
   display.setTextWrap(false);
-  display.setFullWindow();
+  setFullWindow();
   display.firstPage();
   display.fillScreen(GxEPD_WHITE);
 }
 
 void Display::clear()
 {
+  waitForRefresh();
   display.clearScreen();
 }
 
 void Display::refresh()
 {
+  waitForRefresh();
   display.refresh();
 }
 
-void Display::drawPixel(size_t x, size_t y, uint16_t color)
+void Display::setFullWindow()
+{
+  waitForRefresh();
+  flushRows();
+  windowY = 0;
+  windowHeight = GxEPD2_DRIVER_CLASS::HEIGHT;
+  display.setFullWindow();
+}
+
+void Display::setPartialWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+  waitForRefresh();
+  flushRows();
+  // Rows of the window on the panel, GxEPD2 pages through those.
+  switch (rotation)
+  {
+  case 1:
+    windowY = x;
+    windowHeight = w;
+    break;
+  case 2:
+    windowY = GxEPD2_DRIVER_CLASS::HEIGHT - y - h;
+    windowHeight = h;
+    break;
+  case 3:
+    windowY = GxEPD2_DRIVER_CLASS::HEIGHT - x - w;
+    windowHeight = w;
+    break;
+  default:
+    windowY = y;
+    windowHeight = h;
+    break;
+  }
+  display.setPartialWindow(x, y, w, h);
+}
+
+void Display::drawPixel(int16_t x, int16_t y, uint16_t color)
+{
+  flushRows();
+  display.drawPixel(x, y, color);
+}
+
+// Maps (x, y) like GxEPD2's drawPixel(): rotation, partial window, page.
+bool Display::toBuffer(int16_t x, int16_t y, int16_t &bx, int16_t &by)
+{
+  if (x < 0 || x >= (int16_t)width() || y < 0 || y >= (int16_t)height())
+  {
+    return false;
+  }
+  int16_t px, py;
+  switch (rotation)
+  {
+  case 1:
+    px = GxEPD2_DRIVER_CLASS::WIDTH - y - 1;
+    py = x;
+    break;
+  case 2:
+    px = GxEPD2_DRIVER_CLASS::WIDTH - x - 1;
+    py = GxEPD2_DRIVER_CLASS::HEIGHT - y - 1;
+    break;
+  case 3:
+    px = y;
+    py = GxEPD2_DRIVER_CLASS::HEIGHT - x - 1;
+    break;
+  default:
+    px = x;
+    py = y;
+    break;
+  }
+  bx = px - display.*get(_pw_xTag());
+  by = py - display.*get(_pw_yTag());
+  if (bx < 0 || bx >= (int16_t)(display.*get(_pw_wTag())) || by < 0 || by >= (int16_t)(display.*get(_pw_hTag())))
+  {
+    return false;
+  }
+  by -= curPage * pageHeight();
+  return by >= 0 && by < (int16_t)pageHeight();
+}
+
+uint8_t Display::readCode(int16_t bx, int16_t by)
+{
+  const uint16_t stride = display.*get(_pw_wTag()) / DISPLAY_PIXELS_PER_BYTE;
+  const uint32_t index = bx / DISPLAY_PIXELS_PER_BYTE + (uint32_t)by * stride;
+  const uint8_t mask = pixelMask(bx);
+#if defined(DISP_7C)
+  uint8_t value = plane(display, 0)[index] & mask;
+  return mask == 0xF0 ? value >> 4 : value;
+#else
+  return ((plane(display, 0)[index] & mask) ? 1 : 0) | ((plane(display, 1)[index] & mask) ? 2 : 0);
+#endif
+}
+
+int16_t Display::readPixel(int16_t x, int16_t y)
+{
+  flushRows();
+  int16_t bx, by;
+  return toBuffer(x, y, bx, by) ? readCode(bx, by) : -1;
+}
+
+bool Display::hasDirectAccess()
+{
+  return directAccess;
+}
+
+const Display::NativeColor *Display::nativeColor(uint16_t color)
+{
+  if (!directAccess)
+  {
+    return nullptr;
+  }
+  if (lastColor < numNativeColors && nativeColors[lastColor].color == color)
+  {
+    return &nativeColors[lastColor];
+  }
+  for (uint8_t i = 0; i < numNativeColors; i++)
+  {
+    if (nativeColors[i].color == color)
+    {
+      lastColor = i;
+      return &nativeColors[i];
+    }
+  }
+  return nullptr;
+}
+
+// Fills buffer columns bx0..bx1 of rows by0..by1, whole bytes at once.
+void Display::fillBuffer(int16_t bx0, int16_t by0, int16_t bx1, int16_t by1, const NativeColor &color)
+{
+  const uint16_t stride = display.*get(_pw_wTag()) / DISPLAY_PIXELS_PER_BYTE;
+  const int16_t firstByte = bx0 / DISPLAY_PIXELS_PER_BYTE;
+  const int16_t lastByte = bx1 / DISPLAY_PIXELS_PER_BYTE;
+  // Pixels of the first and the last byte inside the rectangle.
+  uint8_t firstMask = 0;
+  uint8_t lastMask = 0;
+  for (int16_t bx = bx0; bx < (firstByte + 1) * DISPLAY_PIXELS_PER_BYTE && bx <= bx1; bx++)
+  {
+    firstMask |= pixelMask(bx);
+  }
+  for (int16_t bx = lastByte * DISPLAY_PIXELS_PER_BYTE; bx <= bx1; bx++)
+  {
+    lastMask |= pixelMask(bx);
+  }
+  for (uint8_t p = 0; p < DISPLAY_PLANES; p++)
+  {
+    const uint8_t pattern = color.pattern[p];
+    for (int16_t by = by0; by <= by1; by++)
+    {
+      uint8_t *row = plane(display, p) + (uint32_t)by * stride;
+      if (firstByte == lastByte)
+      {
+        row[firstByte] = (row[firstByte] & ~firstMask) | (pattern & firstMask);
+        continue;
+      }
+      row[firstByte] = (row[firstByte] & ~firstMask) | (pattern & firstMask);
+      memset(row + firstByte + 1, pattern, lastByte - firstByte - 1);
+      row[lastByte] = (row[lastByte] & ~lastMask) | (pattern & lastMask);
+    }
+  }
+}
+
+void Display::fillScreen(uint16_t color)
+{
+  flushRows();
+  display.fillScreen(color);
+}
+
+void Display::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+  flushRows();
+  const NativeColor *native = nativeColor(color);
+  if (native == nullptr)
+  {
+    display.fillRect(x, y, w, h, color);
+    return;
+  }
+  // Clipped to the panel, then to the window and the page by the corners.
+  int16_t x0 = max<int16_t>(x, 0);
+  int16_t y0 = max<int16_t>(y, 0);
+  int16_t x1 = min<int16_t>(x + w, width()) - 1;
+  int16_t y1 = min<int16_t>(y + h, height()) - 1;
+  if (x0 > x1 || y0 > y1)
+  {
+    return;
+  }
+  // Any rotation maps the rectangle to a rectangle of the buffer. Its
+  // corners may fall outside the window, so they are mapped unclipped.
+  int16_t bx0, by0, bx1, by1;
+  switch (rotation)
+  {
+  case 1:
+    bx0 = GxEPD2_DRIVER_CLASS::WIDTH - 1 - y1;
+    bx1 = GxEPD2_DRIVER_CLASS::WIDTH - 1 - y0;
+    by0 = x0;
+    by1 = x1;
+    break;
+  case 2:
+    bx0 = GxEPD2_DRIVER_CLASS::WIDTH - 1 - x1;
+    bx1 = GxEPD2_DRIVER_CLASS::WIDTH - 1 - x0;
+    by0 = GxEPD2_DRIVER_CLASS::HEIGHT - 1 - y1;
+    by1 = GxEPD2_DRIVER_CLASS::HEIGHT - 1 - y0;
+    break;
+  case 3:
+    bx0 = y0;
+    bx1 = y1;
+    by0 = GxEPD2_DRIVER_CLASS::HEIGHT - 1 - x1;
+    by1 = GxEPD2_DRIVER_CLASS::HEIGHT - 1 - x0;
+    break;
+  default:
+    bx0 = x0;
+    bx1 = x1;
+    by0 = y0;
+    by1 = y1;
+    break;
+  }
+  const int16_t pageTop = curPage * pageHeight();
+  bx0 = max<int16_t>(bx0 - display.*get(_pw_xTag()), 0);
+  bx1 = min<int16_t>(bx1 - display.*get(_pw_xTag()), display.*get(_pw_wTag()) - 1);
+  by0 = max<int16_t>(by0 - display.*get(_pw_yTag()), pageTop) - pageTop;
+  by1 = min<int16_t>(min<int16_t>(by1 - display.*get(_pw_yTag()), display.*get(_pw_hTag()) - 1), pageTop + pageHeight() - 1) - pageTop;
+  if (bx0 <= bx1 && by0 <= by1)
+  {
+    fillBuffer(bx0, by0, bx1, by1, *native);
+  }
+}
+
+void Display::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+  fillRect(x, y, w, 1, color);
+}
+
+void Display::drawRow(int16_t x, int16_t y, const uint16_t *colors, uint16_t w)
 {
+  if (!directAccess)
+  {
+    for (uint16_t i = 0; i < w; i++)
+    {
+      display.drawPixel(x + i, y, colors[i]);
+    }
+    return;
+  }
+  // Pixels of the row on the panel.
+  const uint16_t first = max<int16_t>(-x, 0);
+  const uint16_t end = max<int16_t>(min<int16_t>((int16_t)width() - x, w), 0);
+  if (y < 0 || y >= (int16_t)height() || first >= end)
+  {
+    return;
+  }
+
+  if (rotation == 1 || rotation == 3)
+  {
+    // The row is a panel column, held in the strip by the pixel it takes
+    // in its buffer bytes.
+    const int16_t px = rotation == 1 ? GxEPD2_DRIVER_CLASS::WIDTH - y - 1 : y;
+    const int16_t bx = px - display.*get(_pw_xTag());
+    if (bx < 0 || bx >= (int16_t)(display.*get(_pw_wTag())))
+    {
+      return;
+    }
+    const int16_t column = bx / DISPLAY_PIXELS_PER_BYTE;
+    const uint8_t slot = bx % DISPLAY_PIXELS_PER_BYTE;
+    if (column != stripColumn)
+    {
+      flushRows();
+      stripColumn = column;
+      stripFirst = DISPLAY_STRIP_BYTES;
+      stripLast = 0;
+    }
+    stripFirst = min<uint16_t>(stripFirst, (x + first) / DISPLAY_PIXELS_PER_BYTE);
+    stripLast = max<uint16_t>(stripLast, (x + end - 1) / DISPLAY_PIXELS_PER_BYTE);
+    for (uint16_t i = first; i < end; i++)
+    {
+      const NativeColor *native = nativeColor(colors[i]);
+      if (native == nullptr)
+      {
+        // Left out of the strip, the flush keeps what GxEPD2 drew.
+        strip[DISPLAY_PLANES][slot][(x + i) / DISPLAY_PIXELS_PER_BYTE] &= ~pixelMask(x + i);
+        display.drawPixel(x + i, y, colors[i]);
+        continue;
+      }
+      const uint16_t sx = x + i;
+      const uint8_t mask = pixelMask(sx);
+      const uint16_t index = sx / DISPLAY_PIXELS_PER_BYTE;
+      for (uint8_t p = 0; p < DISPLAY_PLANES; p++)
+      {
+        strip[p][slot][index] = (strip[p][slot][index] & ~mask) | (native->pattern[p] & mask);
+      }
+      strip[DISPLAY_PLANES][slot][index] |= mask;
+    }
+    return;
+  }
+
+  // Upright or upside down, the row is a buffer row, filled a byte at a
+  // time: forwards, or backwards for the half turn.
+  flushRows();
+  const int16_t step = rotation == 2 ? -1 : 1;
+  const int16_t px = rotation == 2 ? GxEPD2_DRIVER_CLASS::WIDTH - x - 1 : x;
+  const int16_t py = rotation == 2 ? GxEPD2_DRIVER_CLASS::HEIGHT - y - 1 : y;
+  int16_t by = py - display.*get(_pw_yTag());
+  if (by < 0 || by >= (int16_t)(display.*get(_pw_hTag())))
+  {
+    return;
+  }
+  by -= curPage * pageHeight();
+  if (by < 0 || by >= (int16_t)pageHeight())
+  {
+    return;
+  }
+  const int16_t windowWidth = display.*get(_pw_wTag());
+  uint8_t *rows[DISPLAY_PLANES];
+  for (uint8_t p = 0; p < DISPLAY_PLANES; p++)
+  {
+    rows[p] = plane(display, p) + (uint32_t)by * (windowWidth / DISPLAY_PIXELS_PER_BYTE);
+  }
+  uint8_t values[DISPLAY_PLANES] = {};
+  uint8_t written = 0;
+  int16_t byteIndex = -1;
+  for (uint16_t i = first; i < end; i++)
+  {
+    const int16_t bx = px + step * i - display.*get(_pw_xTag());
+    if (bx < 0 || bx >= windowWidth)
+    {
+      continue;
+    }
+    if (bx / DISPLAY_PIXELS_PER_BYTE != byteIndex)
+    {
+      if (written != 0)
+      {
+        for (uint8_t p = 0; p < DISPLAY_PLANES; p++)
+        {
+          rows[p][byteIndex] = (rows[p][byteIndex] & ~written) | (values[p] & written);
+        }
+      }
+      byteIndex = bx / DISPLAY_PIXELS_PER_BYTE;
+      written = 0;
+    }
+    const NativeColor *native = nativeColor(colors[i]);
+    if (native == nullptr)
+    {
+      display.drawPixel(x + i, y, colors[i]);
+      continue;
+    }
+    const uint8_t mask = pixelMask(bx);
+    for (uint8_t p = 0; p < DISPLAY_PLANES; p++)
+    {
+      values[p] = (values[p] & ~mask) | (native->pattern[p] & mask);
+    }
+    written |= mask;
+  }
+  if (written != 0)
+  {
+    for (uint8_t p = 0; p < DISPLAY_PLANES; p++)
+    {
+      rows[p][byteIndex] = (rows[p][byteIndex] & ~written) | (values[p] & written);
+    }
+  }
+}
+
+void Display::flushRows()
+{
+  if (stripColumn < 0)
+  {
+    return;
+  }
+  const uint16_t stride = display.*get(_pw_wTag()) / DISPLAY_PIXELS_PER_BYTE;
+  const int16_t pageTop = curPage * pageHeight();
+  for (uint16_t index = stripFirst; index <= stripLast && index < DISPLAY_STRIP_BYTES; index++)
+  {
+    uint8_t tile[DISPLAY_PIXELS_PER_BYTE];
+    uint8_t masks[DISPLAY_PIXELS_PER_BYTE];
+    uint8_t any = 0;
+    for (uint8_t slot = 0; slot < DISPLAY_PIXELS_PER_BYTE; slot++)
+    {
+      tile[slot] = strip[DISPLAY_PLANES][slot][index];
+      any |= tile[slot];
+    }
+    if (any == 0)
+    {
+      continue;
+    }
+    transposeTile(tile, masks);
+    uint8_t values[DISPLAY_PLANES][DISPLAY_PIXELS_PER_BYTE];
+    for (uint8_t p = 0; p < DISPLAY_PLANES; p++)
+    {
+      for (uint8_t slot = 0; slot < DISPLAY_PIXELS_PER_BYTE; slot++)
+      {
+        tile[slot] = strip[p][slot][index];
+      }
+      transposeTile(tile, values[p]);
+    }
+    // Byte j of the transposed tile is the panel row of strip pixel j.
+    for (uint8_t j = 0; j < DISPLAY_PIXELS_PER_BYTE; j++)
+    {
+      if (masks[j] == 0)
+      {
+        continue;
+      }
+      const int16_t sx = index * DISPLAY_PIXELS_PER_BYTE + j;
+      const int16_t py = rotation == 1 ? sx : GxEPD2_DRIVER_CLASS::HEIGHT - sx - 1;
+      int16_t by = py - display.*get(_pw_yTag());
+      if (by < 0 || by >= (int16_t)(display.*get(_pw_hTag())))
+      {
+        continue;
+      }
+      by -= pageTop;
+      if (by < 0 || by >= (int16_t)pageHeight())
+      {
+        continue;
+      }
+      const uint32_t offset = (uint32_t)by * stride + stripColumn;
+      for (uint8_t p = 0; p < DISPLAY_PLANES; p++)
+      {
+        uint8_t *byte = plane(display, p) + offset;
+        *byte = (*byte & ~masks[j]) | (values[p][j] & masks[j]);
+      }
+    }
+  }
+  for (uint8_t p = 0; p <= DISPLAY_PLANES; p++)
+  {
+    for (uint8_t slot = 0; slot < DISPLAY_PIXELS_PER_BYTE; slot++)
+    {
+      memset(&strip[p][slot][stripFirst], 0, stripLast - stripFirst + 1);
+    }
+  }
+  stripColumn = -1;
+}
+
+// Draws `color` at (x, y) with GxEPD2 and reads back its code, the rest of
+// the byte must stay white. The pixel is white again afterwards.
+bool Display::checkPixel(int16_t x, int16_t y, uint16_t color, uint8_t &code)
+{
+  int16_t bx, by;
+  if (!toBuffer(x, y, bx, by))
+  {
+    return false;
+  }
+  const uint8_t white = readCode(bx, by);
+  const uint32_t index = bx / DISPLAY_PIXELS_PER_BYTE + (uint32_t)by * (display.*get(_pw_wTag()) / DISPLAY_PIXELS_PER_BYTE);
+  uint8_t before[DISPLAY_PLANES];
+  for (uint8_t p = 0; p < DISPLAY_PLANES; p++)
+  {
+    before[p] = plane(display, p)[index];
+  }
   display.drawPixel(x, y, color);
+  code = readCode(bx, by);
+  bool untouched = true;
+  for (uint8_t p = 0; p < DISPLAY_PLANES; p++)
+  {
+    untouched = untouched && ((plane(display, p)[index] ^ before[p]) & ~pixelMask(bx)) == 0;
+  }
+  display.drawPixel(x, y, GxEPD_WHITE);
+  return untouched && readCode(bx, by) == white;
+}
+
+// Learns the code GxEPD2 stores for every palette color and checks that
+// pixels land where toBuffer() says, in the full window and in a partial
+// one that is not byte aligned. Points off the first page are skipped.
+// False when anything disagrees.
+bool Display::verifyBuffer()
+{
+  static const uint16_t colors[DISPLAY_NATIVE_COLORS] = {GxEPD_WHITE, GxEPD_BLACK, GxEPD_RED, GxEPD_YELLOW, GxEPD_GREEN, GxEPD_BLUE, GxEPD_ORANGE};
+  const int16_t w = width();
+  const int16_t h = height();
+  const int16_t fullPoints[][2] = {{0, 0}, {(int16_t)(w - 1), 0}, {0, (int16_t)(h - 1)}, {(int16_t)(w - 1), (int16_t)(h - 1)}, {(int16_t)(w / 3), (int16_t)(h / 4)}};
+  const int16_t partialPoints[][2] = {{9, 5}, {29, 17}, {16, 11}};
+  int16_t bx, by;
+  uint8_t code;
+  uint8_t white;
+  uint8_t black;
+  numNativeColors = 0;
+  lastColor = 0;
+
+  // Colors are learnt on the first point of the page.
+  const int16_t *learnPoint = nullptr;
+  for (const auto &point : fullPoints)
+  {
+    if (learnPoint == nullptr && toBuffer(point[0], point[1], bx, by))
+    {
+      learnPoint = point;
+    }
+  }
+  if (learnPoint == nullptr || !checkPixel(learnPoint[0], learnPoint[1], GxEPD_WHITE, white)
+      || !checkPixel(learnPoint[0], learnPoint[1], GxEPD_BLACK, black) || black == white)
+  {
+    return false;
+  }
+  for (uint8_t i = 0; i < DISPLAY_NATIVE_COLORS; i++)
+  {
+    if (!checkPixel(learnPoint[0], learnPoint[1], colors[i], code))
+    {
+      return false;
+    }
+    NativeColor &native = nativeColors[numNativeColors++];
+    native.color = colors[i];
+    native.code = code;
+    for (uint8_t p = 0; p < DISPLAY_PLANES; p++)
+    {
+#if defined(DISP_7C)
+      native.pattern[p] = code * 0x11;
+#else
+      native.pattern[p] = (code >> p) & 1 ? 0xFF : 0x00;
+#endif
+    }
+  }
+
+  for (const auto &point : fullPoints)
+  {
+    if (toBuffer(point[0], point[1], bx, by) && (!checkPixel(point[0], point[1], GxEPD_BLACK, code) || code != black))
+    {
+      return false;
+    }
+  }
+  display.setPartialWindow(9, 5, 21, 13);
+  display.firstPage();
+  display.fillScreen(GxEPD_WHITE);
+  for (const auto &point : partialPoints)
+  {
+    if (!toBuffer(point[0], point[1], bx, by) || !checkPixel(point[0], point[1], GxEPD_BLACK, code) || code != black)
+    {
+      return false;
+    }
+  }
+  return true;
 }
 
 size_t Display::height()
@@ -64,7 +676,7 @@ uint16_t Display::numPages()
 size_t Display::getPageHeight(size_t pageIdx)
 { 
   uint16_t numPages = this->numPages();
-  size_t height = this->height();
+  size_t height = windowHeight;
   uint16_t pageHeight = this->pageHeight();
 
   if (pageIdx >= numPages)
@@ -86,8 +698,70 @@ size_t Display::getPageHeight()
   return getPageHeight(curPage);
 }
 
+void Display::pageBounds(int16_t &x, int16_t &y, int16_t &w, int16_t &h)
+{
+  const int16_t panelWidth = GxEPD2_DRIVER_CLASS::WIDTH;
+  const int16_t panelHeight = GxEPD2_DRIVER_CLASS::HEIGHT;
+  int16_t top = windowY + curPage * pageHeight();
+  int16_t rows = getPageHeight();
+  switch (rotation)
+  {
+  case 1:
+    x = top;
+    y = 0;
+    w = rows;
+    h = panelWidth;
+    break;
+  case 2:
+    x = 0;
+    y = panelHeight - top - rows;
+    w = panelWidth;
+    h = rows;
+    break;
+  case 3:
+    x = panelHeight - top - rows;
+    y = 0;
+    w = rows;
+    h = panelWidth;
+    break;
+  default:
+    x = 0;
+    y = top;
+    w = panelWidth;
+    h = rows;
+    break;
+  }
+}
+
+void Display::firstPage()
+{
+  waitForRefresh();
+  flushRows();
+  asyncRefresh = false;
+  curPage = 0;
+  display.firstPage();
+}
+
 boolean Display::nextPage()
 {
+  flushRows();
+  if (asyncRefresh && curPage + 1 >= numPages())
+  {
+    // The last page writes the buffer and refreshes, GxEPD2 then polls BUSY
+    // until the waveform is done. The task yields while it polls.
+    asyncRefresh = false;
+    refreshDone = xSemaphoreCreateBinary();
+    if (refreshDone != nullptr && xTaskCreate(runRefresh, "refresh", DISPLAY_REFRESH_STACK_SIZE, this, 1, nullptr) == pdPASS)
+    {
+      return false;
+    }
+    Serial.println("Could not start the refresh task, refreshing in place");
+    if (refreshDone != nullptr)
+    {
+      vSemaphoreDelete(refreshDone);
+      refreshDone = nullptr;
+    }
+  }
   if (display.nextPage())
   {
     curPage++;
@@ -98,3 +772,36 @@ boolean Display::nextPage()
     return false;
   }
 }
+
+void Display::refreshAsync()
+{
+  asyncRefresh = true;
+}
+
+void Display::cancelRefreshAsync()
+{
+  asyncRefresh = false;
+}
+
+void Display::waitForRefresh()
+{
+  if (refreshDone == nullptr)
+  {
+    return;
+  }
+  xSemaphoreTake(refreshDone, portMAX_DELAY);
+  vSemaphoreDelete(refreshDone);
+  refreshDone = nullptr;
+}
+
+void Display::runRefresh(void *arg)
+{
+  Display *self = static_cast<Display *>(arg);
+  uint32_t startTime = millis();
+  self->display.nextPage();
+  Serial.print("Refresh done in ");
+  Serial.print(millis() - startTime);
+  Serial.println(" ms");
+  xSemaphoreGive(self->refreshDone);
+  vTaskDelete(nullptr);
+}
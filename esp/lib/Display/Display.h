@@ -4,6 +4,8 @@
 #define ENABLE_GxEPD2_GFX 0
 
 #include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 
 // #if defined(GxEPD2_DISPLAY_CLASS) && GxEPD2_DISPLAY_CLASS == GxEPD2_7C
 #if defined(DISP_7C)
@@ -18,30 +20,115 @@
 #define DC_PIN 20
 #define RST_PIN 19
 #define BUSY_PIN 1
+#define DISPLAY_REFRESH_STACK_SIZE 4096
 #define MAX_DISPLAY_BUFFER_SIZE 655360ul
+// Quarter turns clockwise of the mounted panel, as in Adafruit_GFX.
+#ifndef DISPLAY_ROTATION
+#define DISPLAY_ROTATION 0
+#endif
 #define MAX_HEIGHT(EPD) (EPD::HEIGHT <= (MAX_DISPLAY_BUFFER_SIZE) / (EPD::WIDTH / 2) ? EPD::HEIGHT : (MAX_DISPLAY_BUFFER_SIZE) / (EPD::WIDTH / 2))
 
+// Layout of the GxEPD2 page buffer: 3C panels keep a black and a color plane
+// of one bit per pixel, 7C panels a 4-bit color code per pixel.
+#if defined(DISP_7C)
+#define DISPLAY_PLANES 1
+#define DISPLAY_PIXELS_PER_BYTE 2
+#else
+#define DISPLAY_PLANES 2
+#define DISPLAY_PIXELS_PER_BYTE 8
+#endif
+#define DISPLAY_NATIVE_COLORS 7
+// Rows held for a quarter-turn transpose span the panel height.
+#define DISPLAY_STRIP_BYTES ((GxEPD2_DRIVER_CLASS::HEIGHT + DISPLAY_PIXELS_PER_BYTE - 1) / DISPLAY_PIXELS_PER_BYTE)
+
 class Display
 {
+public:
+    typedef GxEPD2_DISPLAY_CLASS<GxEPD2_DRIVER_CLASS, MAX_HEIGHT(GxEPD2_DRIVER_CLASS)> Panel;
+
+private:
+    struct NativeColor
+    {
+        uint16_t color;
+        uint8_t code;                     // as returned by readPixel()
+        uint8_t pattern[DISPLAY_PLANES];  // the code in every pixel of a byte
+    };
+
+    bool asyncRefresh;
+    SemaphoreHandle_t refreshDone; // set while a refresh runs on its task
+    bool directAccess;             // the page buffer layout checked out
+    NativeColor nativeColors[DISPLAY_NATIVE_COLORS];
+    uint8_t numNativeColors;
+    uint8_t lastColor; // index of the last color looked up
+    // Rows of a quarter-turned panel are panel columns. They are held here,
+    // one per pixel of a buffer byte, until the byte column is complete.
+    // The last plane marks the pixels written.
+    uint8_t strip[DISPLAY_PLANES + 1][DISPLAY_PIXELS_PER_BYTE][DISPLAY_STRIP_BYTES];
+    int16_t stripColumn; // byte column of the buffer held, -1 when none
+    uint16_t stripFirst; // strip bytes written
+    uint16_t stripLast;
+
+    static void runRefresh(void *display);
+    bool toBuffer(int16_t x, int16_t y, int16_t &bx, int16_t &by);
+    uint8_t readCode(int16_t bx, int16_t by);
+    const NativeColor *nativeColor(uint16_t color);
+    void fillBuffer(int16_t bx0, int16_t by0, int16_t bx1, int16_t by1, const NativeColor &color);
+    bool checkPixel(int16_t x, int16_t y, uint16_t color, uint8_t &code);
+    bool verifyBuffer();
 
 public:
-    GxEPD2_DISPLAY_CLASS<GxEPD2_DRIVER_CLASS, MAX_HEIGHT(GxEPD2_DRIVER_CLASS)> display = GxEPD2_DRIVER_CLASS(CS_PIN, DC_PIN, RST_PIN, BUSY_PIN);
+    Panel display = GxEPD2_DRIVER_CLASS(CS_PIN, DC_PIN, RST_PIN, BUSY_PIN);
     boolean hasMultiColors;
     uint16_t curPage;
+    uint8_t rotation;
+    uint16_t windowY;      // top of the window being drawn, in panel rows
+    uint16_t windowHeight; // in panel rows
 
     Display();
     void initDisplay();
     void reset();
     void clear();
     void refresh();
-    void drawPixel(size_t x, size_t y, uint16_t color);
+    void setFullWindow();
+    void setPartialWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+    void drawPixel(int16_t x, int16_t y, uint16_t color);
+    // The drawing calls below write the page buffer of GxEPD2 directly, a byte
+    // at a time, once initDisplay() checked its layout against GxEPD2's own
+    // drawPixel(). Otherwise, and for colors GxEPD2 has to convert, they go
+    // through GxEPD2 pixel by pixel.
+    void fillScreen(uint16_t color);
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+    // Draws `w` pixels from (x, y) rightwards. Upright and upside down, a row
+    // is packed straight into a buffer row, reversed for the half turn. With
+    // a quarter turn it is a panel column: rows are held until a byte column
+    // is complete, then transposed into place 8x8 bits (2x2 nibbles on 7C).
+    // Call flushRows() once the rows are drawn.
+    void drawRow(int16_t x, int16_t y, const uint16_t *colors, uint16_t w);
+    void flushRows();
+    // Panel code of the pixel at (x, y) in the page buffer, -1 outside the
+    // current page: the black plane bit, and the color plane bit times 2 on
+    // 3C panels, the 4-bit color on 7C ones.
+    int16_t readPixel(int16_t x, int16_t y);
+    bool hasDirectAccess();
+    void firstPage();
     boolean nextPage();
+    // The refresh at the end of the current page loop runs on its own task:
+    // the last nextPage() returns once the refresh has started. Until
+    // waitForRefresh() returns, nothing else may touch the panel. Call after
+    // firstPage(), which drops a request left by an abandoned page loop.
+    void refreshAsync();
+    void cancelRefreshAsync();
+    void waitForRefresh();
     size_t height();
     size_t width();
     uint16_t pageHeight();
     uint16_t numPages();
     size_t getPageHeight();
     size_t getPageHeight(size_t pageIdx);
+    // Area the current page covers, in rotated coordinates. Pages are bands
+    // of panel rows, so with a quarter turn they are bands of columns.
+    void pageBounds(int16_t &x, int16_t &y, int16_t &w, int16_t &h);
 };
 
 #endif // __DISPLAY_H__
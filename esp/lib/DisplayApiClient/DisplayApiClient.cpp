@@ -1,8 +1,15 @@
 #include "DisplayApiClient.h"
 
+static const char *CONFIG_VERSION_HEADER = "X-Config-Version";
+static const char *DATE_HEADER = "Date";
+static const char *TRANSFER_ENCODING_HEADER = "Transfer-Encoding";
+static const char *collectedHeaders[] = {CONFIG_VERSION_HEADER, DATE_HEADER, TRANSFER_ENCODING_HEADER};
+
 DisplayApiClient::DisplayApiClient(const char *baseUrl)
     : _baseUrl(baseUrl)
 {
+    _httpClient.setReuse(true);
+    _httpClient.collectHeaders(collectedHeaders, sizeof(collectedHeaders) / sizeof(collectedHeaders[0]));
 }
 
 DisplayApiClient::~DisplayApiClient()
@@ -14,25 +21,153 @@ bool DisplayApiClient::getDisplayInfo(int displayId, DisplayInfo &config)
 {
     char path[64];
     snprintf(path, sizeof(path), "/eink/display/%d", displayId);
-    JsonDocument responseJson;
-    if (sendRequest(path, "GET", nullptr, responseJson))
+    char etag[16] = "";
+    if (config.id == displayId && config.version > 0)
+    {
+        snprintf(etag, sizeof(etag), "\"v%d\"", config.version);
+    }
+    _jsonArena.reset();
+    JsonDocument filter(&_jsonArena);
+    DisplayInfo::buildFilter(filter.to<JsonObject>());
+    JsonDocument responseJson(&_jsonArena);
+    if (sendRequest(path, "GET", nullptr, &responseJson, &filter, etag[0] != '\0' ? etag : nullptr))
     {
+        if (responseJson.isNull())
+        {
+            Serial.println("Display config not modified.");
+            return true;
+        }
         return config.deserialize(responseJson);
     }
     return false;
 }
 
+bool DisplayApiClient::getDisplayInfoCached(int displayId, DisplayInfo &config, time_t now)
+{
+    bool cached = DisplayInfoCache::load(displayId, config);
+    if (cached && DisplayInfoCache::isFresh(now))
+    {
+        return true;
+    }
+    if (!cached)
+    {
+        config = DisplayInfo();
+    }
+    if (!getDisplayInfo(displayId, config))
+    {
+        // A stale config is still better than none.
+        return cached;
+    }
+    DisplayInfoCache::store(config, now);
+    return true;
+}
+
+bool DisplayApiClient::getManifest(int displayId, WakeManifest &manifest)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/eink/display/%d/manifest", displayId);
+    _jsonArena.reset();
+    JsonDocument filter(&_jsonArena);
+    WakeManifest::buildFilter(filter.to<JsonObject>());
+    JsonDocument responseJson(&_jsonArena);
+    if (sendRequest(path, "GET", nullptr, &responseJson, &filter))
+    {
+        return manifest.deserialize(responseJson);
+    }
+    return false;
+}
+
+bool DisplayApiClient::getPlaylist(int displayId, uint8_t length, Playlist &playlist)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/eink/display/%d/playlist?length=%u", displayId, length);
+    _jsonArena.reset();
+    JsonDocument filter(&_jsonArena);
+    Playlist::buildFilter(filter.to<JsonObject>());
+    JsonDocument responseJson(&_jsonArena);
+    if (sendRequest(path, "GET", nullptr, &responseJson, &filter))
+    {
+        return playlist.deserialize(responseJson);
+    }
+    return false;
+}
+
 bool DisplayApiClient::createDisplayUpdate(int displayId, const UpdateInfo &update)
 {
     char path[64];
     snprintf(path, sizeof(path), "/eink/display/%d/update", displayId);
-    JsonDocument payloadJson;
-    update.serialize(payloadJson);
-    JsonDocument responseJson;
-    return sendRequest(path, "POST", &payloadJson, responseJson);
+    _jsonArena.reset();
+    JsonDocument payloadJson(&_jsonArena);
+    update.serialize(payloadJson.to<JsonObject>());
+    return sendRequest(path, "POST", &payloadJson);
+}
+
+bool DisplayApiClient::flushUpdates(int displayId, time_t now)
+{
+    if (UpdateQueue::size() == 0 && UpdateQueue::dropped() == 0)
+    {
+        return true;
+    }
+    char path[64];
+    snprintf(path, sizeof(path), "/eink/display/%d/updates", displayId);
+    _jsonArena.reset();
+    JsonDocument payloadJson(&_jsonArena);
+    UpdateQueue::serialize(payloadJson, now);
+    if (!sendRequest(path, "POST", &payloadJson))
+    {
+        return false;
+    }
+    UpdateQueue::clear();
+    return true;
+}
+
+int DisplayApiClient::download(const char *path, uint8_t *buffer, size_t size)
+{
+    if (WiFi.status() != WL_CONNECTED)
+    {
+        Serial.println("WiFi is not connected.");
+        return -1;
+    }
+
+    String url = String(_baseUrl) + path;
+    beginRequest(_httpClient, _secureClient, url);
+    int httpCode = _httpClient.GET();
+    int length = -1;
+    if (httpCode == HTTP_CODE_OK)
+    {
+        int expected = _httpClient.getSize();
+        if (expected > 0 && (size_t)expected <= size)
+        {
+            size_t received = _httpClient.getStreamPtr()->readBytes(buffer, expected);
+            length = received == (size_t)expected ? expected : -1;
+        }
+        if (length < 0)
+        {
+            Serial.print("Could not read ");
+            Serial.print(expected);
+            Serial.println(" bytes response");
+        }
+    }
+    else
+    {
+        Serial.print("HTTP error: ");
+        Serial.println(httpCode);
+    }
+    _httpClient.end();
+    return length;
 }
 
-bool DisplayApiClient::sendRequest(const char *path, const char *method, const JsonDocument *payloadJson, JsonDocument &responseJson)
+HTTPClient &DisplayApiClient::httpClient()
+{
+    return _httpClient;
+}
+
+ResumableSecureClient &DisplayApiClient::secureClient()
+{
+    return _secureClient;
+}
+
+bool DisplayApiClient::sendRequest(const char *path, const char *method, const JsonDocument *payloadJson, JsonDocument *responseJson, const JsonDocument *filter, const char *ifNoneMatch)
 {
     if (WiFi.status() != WL_CONNECTED)
     {
@@ -40,10 +175,29 @@ bool DisplayApiClient::sendRequest(const char *path, const char *method, const J
         return false;
     }
 
+    char payload[DISPLAY_API_PAYLOAD_SIZE];
+    size_t length = 0;
+    if (payloadJson != nullptr)
+    {
+        length = measureJson(*payloadJson);
+        if (length >= sizeof(payload))
+        {
+            Serial.print("Request payload of ");
+            Serial.print(length);
+            Serial.println(" bytes is too large");
+            return false;
+        }
+        serializeJson(*payloadJson, payload, sizeof(payload));
+    }
+
     String url = String(_baseUrl) + path;
 
-    _httpClient.begin(url);
+    beginRequest(_httpClient, _secureClient, url);
     _httpClient.addHeader("Content-Type", "application/json");
+    if (ifNoneMatch != nullptr)
+    {
+        _httpClient.addHeader("If-None-Match", ifNoneMatch);
+    }
 
     int httpCode = -1;
 
@@ -53,25 +207,43 @@ bool DisplayApiClient::sendRequest(const char *path, const char *method, const J
     }
     else if (strcmp(method, "POST") == 0)
     {
-        String payload;
-        serializeJson(*payloadJson, payload);
-        httpCode = _httpClient.POST(payload);
+        httpCode = _httpClient.POST(reinterpret_cast<uint8_t *>(payload), length);
     }
 
+    bool success = false;
+    if (_httpClient.hasHeader(CONFIG_VERSION_HEADER))
+    {
+        DisplayInfoCache::onConfigVersion(_httpClient.header(CONFIG_VERSION_HEADER).toInt());
+    }
+    if (_httpClient.hasHeader(DATE_HEADER))
+    {
+        applyHttpDate(_httpClient.header(DATE_HEADER).c_str());
+    }
     if (httpCode > 0)
     {
-        if (httpCode == HTTP_CODE_OK || httpCode == HTTP_CODE_CREATED)
+        if (httpCode == HTTP_CODE_NOT_MODIFIED && ifNoneMatch != nullptr)
         {
-            String response = _httpClient.getString();
-            DeserializationError error = deserializeJson(responseJson, response);
-            if (error)
+            success = true;
+        }
+        else if (httpCode == HTTP_CODE_OK || httpCode == HTTP_CODE_CREATED)
+        {
+            success = true;
+            if (responseJson != nullptr)
             {
-                Serial.print("deserializeJson() failed: ");
-                Serial.println(error.c_str());
-                return false;
+                // Parsed straight from the socket, the connection is then
+                // reused by the frame downloads.
+                ChunkedStream body(_httpClient.getStream(), _httpClient.header(TRANSFER_ENCODING_HEADER).equalsIgnoreCase("chunked"));
+                DeserializationError error = filter != nullptr
+                                                 ? deserializeJson(*responseJson, body, DeserializationOption::Filter(*filter))
+                                                 : deserializeJson(*responseJson, body);
+                body.finish();
+                if (error)
+                {
+                    Serial.print("deserializeJson() failed: ");
+                    Serial.println(error.c_str());
+                    success = false;
+                }
             }
-            deserializeJson(responseJson, response);
-            return true;
         }
         else
         {
@@ -86,5 +258,5 @@ bool DisplayApiClient::sendRequest(const char *path, const char *method, const J
     }
 
     _httpClient.end();
-    return false;
+    return success;
 }
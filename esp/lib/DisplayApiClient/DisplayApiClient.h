@@ -5,22 +5,59 @@
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
 #include <WiFi.h>
+#include <ChunkedStream.h>
+#include <ResumableSecureClient.h>
+#include <timeUtils.h>
 #include "DisplayInfo.h"
+#include "DisplayInfoCache.h"
+#include "JsonArena.h"
+#include "Playlist.h"
+#include "PlaylistCache.h"
 #include "UpdateInfo.h"
+#include "UpdateQueue.h"
+#include "WakeManifest.h"
+
+#ifndef DISPLAY_API_JSON_ARENA_SIZE
+#define DISPLAY_API_JSON_ARENA_SIZE 6144
+#endif
+
+#ifndef DISPLAY_API_PAYLOAD_SIZE
+#define DISPLAY_API_PAYLOAD_SIZE 1024
+#endif
 
 class DisplayApiClient {
 public:
     DisplayApiClient(const char* baseUrl);
     ~DisplayApiClient();
 
+    // Sends a conditional request when `config` already holds a version of
+    // this display; on 304 `config` is left untouched.
     bool getDisplayInfo(int displayId, DisplayInfo& config);
+    // Serves the RTC-cached config while its TTL runs and revalidates it
+    // with a conditional request afterwards.
+    bool getDisplayInfoCached(int displayId, DisplayInfo& config, time_t now);
     bool createDisplayUpdate(int displayId, const UpdateInfo& update);
+    // Sends everything in UpdateQueue as one request and clears it on
+    // success; on failure the entries stay queued for the next wake.
+    bool flushUpdates(int displayId, time_t now);
+    bool getManifest(int displayId, WakeManifest& manifest);
+    bool getPlaylist(int displayId, uint8_t length, Playlist& playlist);
+    // Reads the body of GET `path` into `buffer`; returns its length, or -1
+    // on failure or when it does not fit.
+    int download(const char* path, uint8_t* buffer, size_t size);
+
+    // Connection shared by API calls and frame downloads, kept alive between
+    // requests to the same server.
+    HTTPClient& httpClient();
+    ResumableSecureClient& secureClient();
 
 private:
     const char* _baseUrl;
     HTTPClient _httpClient;
+    ResumableSecureClient _secureClient;
+    JsonArena<DISPLAY_API_JSON_ARENA_SIZE> _jsonArena;
 
-    bool sendRequest(const char* path, const char* method, const JsonDocument* payloadJson, JsonDocument& responseJson);
+    bool sendRequest(const char* path, const char* method, const JsonDocument* payloadJson, JsonDocument* responseJson = nullptr, const JsonDocument* filter = nullptr, const char* ifNoneMatch = nullptr);
 };
 
 #endif // DISPLAY_CONFIG_MANAGER_H
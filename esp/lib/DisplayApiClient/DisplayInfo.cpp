@@ -1,14 +1,73 @@
 #include "DisplayInfo.h"
 
-DisplayInfo::DisplayInfo() {}
+DisplayZone::DisplayZone() : x(0), y(0), width(0), height(0), refreshFrequency(0) {
+    url[0] = '\0';
+    renderer[0] = '\0';
+}
+
+bool DisplayZone::hasUrl() const {
+    return url[0] != '\0';
+}
+
+bool DisplayZone::serialize(JsonObject json) const {
+    json["x"] = x;
+    json["y"] = y;
+    json["width"] = width;
+    json["height"] = height;
+    if (hasUrl()) {
+        json["url"] = url;
+    } else {
+        json["renderer"] = renderer;
+    }
+    json["refresh_frequency"] = refreshFrequency;
+    return true;
+}
+
+bool DisplayZone::deserialize(JsonVariantConst json) {
+    x = json["x"] | 0;
+    y = json["y"] | 0;
+    width = json["width"] | 0;
+    height = json["height"] | 0;
+    strlcpy(url, json["url"] | "", sizeof(url));
+    strlcpy(renderer, json["renderer"] | "", sizeof(renderer));
+    refreshFrequency = json["refresh_frequency"] | 60;
+    return width > 0 && height > 0 && (url[0] != '\0' || renderer[0] != '\0');
+}
+
+DisplayInfo::DisplayInfo() : refreshFrequency(0), fullRefreshFrequency(-1), id(0), version(0), nextChange(0), numWakeTimes(0), numZones(0) {
+    name[0] = '\0';
+    url[0] = '\0';
+    previousUrl[0] = '\0';
+}
+
+DisplayInfo::DisplayInfo(const char* name, const char* url, const char* previousUrl, int refreshFrequency, int fullRefreshFrequency, int id, int version)
+    : refreshFrequency(refreshFrequency), fullRefreshFrequency(fullRefreshFrequency), id(id), version(version), nextChange(0), numWakeTimes(0), numZones(0) {
+    strlcpy(this->name, name, sizeof(this->name));
+    strlcpy(this->url, url, sizeof(this->url));
+    strlcpy(this->previousUrl, previousUrl, sizeof(this->previousUrl));
+}
+
+bool DisplayInfo::hasPreviousUrl() const {
+    return previousUrl[0] != '\0';
+}
 
-DisplayInfo::DisplayInfo(const std::string& name, const std::string& url, const std::string& previousUrl, int refreshFrequency, int fullRefreshFrequency, int id)
-    : name(name), url(url), previousUrl(previousUrl), refreshFrequency(refreshFrequency), fullRefreshFrequency(fullRefreshFrequency), id(id) {}
+int DisplayInfo::wakePeriod() const {
+    if (numZones == 0) {
+        return refreshFrequency;
+    }
+    int period = zones[0].refreshFrequency;
+    for (uint8_t i = 1; i < numZones; i++) {
+        if (zones[i].refreshFrequency > 0 && (period <= 0 || zones[i].refreshFrequency < period)) {
+            period = zones[i].refreshFrequency;
+        }
+    }
+    return period;
+}
 
 bool DisplayInfo::serialize(JsonDocument& doc) const {
     doc["name"] = name;
     doc["url"] = url;
-    if (!previousUrl.empty()) {
+    if (hasPreviousUrl()) {
         doc["previous_url"] = previousUrl;
     } else {
         doc["previous_url"] = nullptr;
@@ -20,16 +79,71 @@ bool DisplayInfo::serialize(JsonDocument& doc) const {
         doc["full_refresh_frequency"] = nullptr;
     }
     doc["id"] = id;
+    doc["version"] = version;
+    if (nextChange > 0) {
+        doc["next_change"] = nextChange;
+    }
+    if (numWakeTimes > 0) {
+        JsonArray times = doc["wake_times"].to<JsonArray>();
+        for (uint8_t i = 0; i < numWakeTimes; i++) {
+            times.add(wakeTimes[i]);
+        }
+    }
+    if (numZones > 0) {
+        JsonArray zonesJson = doc["zones"].to<JsonArray>();
+        for (uint8_t i = 0; i < numZones; i++) {
+            zones[i].serialize(zonesJson.add<JsonObject>());
+        }
+    }
     return true;
 }
 
-bool DisplayInfo::deserialize(const JsonDocument& doc) {
-    name = doc["name"] | "";
-    url = doc["url"] | "";
-    previousUrl = doc["previous_url"] | "";
+bool DisplayInfo::deserialize(JsonVariantConst doc) {
+    strlcpy(name, doc["name"] | "", sizeof(name));
+    strlcpy(url, doc["url"] | "", sizeof(url));
+    strlcpy(previousUrl, doc["previous_url"] | "", sizeof(previousUrl));
     refreshFrequency = doc["refresh_frequency"] | 0;
     fullRefreshFrequency = doc["full_refresh_frequency"] | -1;
 
     id = doc["id"] | 0;
+    version = doc["version"] | 0;
+    numZones = 0;
+    for (JsonVariantConst zone : doc["zones"].as<JsonArrayConst>()) {
+        if (numZones >= DISPLAY_INFO_MAX_ZONES) {
+            break;
+        }
+        if (zones[numZones].deserialize(zone)) {
+            numZones++;
+        }
+    }
+    deserializeSchedule(doc);
     return true;
 }
+
+void DisplayInfo::deserializeSchedule(JsonVariantConst json) {
+    nextChange = json["next_change"] | (time_t)0;
+    numWakeTimes = 0;
+    for (JsonVariantConst wakeTime : json["wake_times"].as<JsonArrayConst>()) {
+        if (numWakeTimes >= DISPLAY_INFO_MAX_WAKE_TIMES) {
+            break;
+        }
+        wakeTimes[numWakeTimes++] = wakeTime | (time_t)0;
+    }
+}
+
+void DisplayInfo::buildFilter(JsonObject filter) {
+    filter["name"] = true;
+    filter["url"] = true;
+    filter["previous_url"] = true;
+    filter["refresh_frequency"] = true;
+    filter["full_refresh_frequency"] = true;
+    filter["id"] = true;
+    filter["version"] = true;
+    filter["zones"] = true;
+    buildScheduleFilter(filter);
+}
+
+void DisplayInfo::buildScheduleFilter(JsonObject filter) {
+    filter["next_change"] = true;
+    filter["wake_times"] = true;
+}
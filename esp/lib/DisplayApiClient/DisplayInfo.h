@@ -2,22 +2,68 @@
 #define DISPLAY_INFO_H
 
 #include <ArduinoJson.h>
-#include <string>
+#include <time.h>
+
+#define DISPLAY_INFO_NAME_SIZE 32
+#define DISPLAY_INFO_URL_SIZE 192
+#define DISPLAY_INFO_MAX_WAKE_TIMES 8
+#define DISPLAY_INFO_MAX_ZONES 3
+#define DISPLAY_ZONE_RENDERER_SIZE 16
+
+// A region of the display refreshed on its own cadence, from a bitmap URL
+// or from a renderer running on the device.
+class DisplayZone {
+public:
+    DisplayZone();
+
+    uint16_t x;
+    uint16_t y;
+    uint16_t width;
+    uint16_t height;
+    char url[DISPLAY_INFO_URL_SIZE];
+    char renderer[DISPLAY_ZONE_RENDERER_SIZE];
+    int refreshFrequency;
+
+    bool hasUrl() const;
+    bool serialize(JsonObject json) const;
+    bool deserialize(JsonVariantConst json);
+};
 
 class DisplayInfo {
 public:
     DisplayInfo();
-    DisplayInfo(const std::string& name, const std::string& url, const std::string& previousUrl, int refreshFrequency,  int fullRefreshFrequency, int id);
+    DisplayInfo(const char* name, const char* url, const char* previousUrl, int refreshFrequency,  int fullRefreshFrequency, int id, int version = 0);
 
-    std::string name;
-    std::string url;
-    std::string previousUrl;
+    char name[DISPLAY_INFO_NAME_SIZE];
+    char url[DISPLAY_INFO_URL_SIZE];
+    char previousUrl[DISPLAY_INFO_URL_SIZE];
     int refreshFrequency;
     int fullRefreshFrequency;
     int id;
+    int version;
+    // Server advice on when the content changes next, 0 when unknown, and
+    // extra scheduled wakes (e.g. a playlist rotation). Both are unix times.
+    time_t nextChange;
+    time_t wakeTimes[DISPLAY_INFO_MAX_WAKE_TIMES];
+    uint8_t numWakeTimes;
+    // When set, the display is updated zone by zone instead of from `url`.
+    DisplayZone zones[DISPLAY_INFO_MAX_ZONES];
+    uint8_t numZones;
+
+    bool hasPreviousUrl() const;
+    // Shortest cadence among the zones, `refreshFrequency` without zones.
+    int wakePeriod() const;
+    // Reads `next_change` and `wake_times` from `json`, which may be the
+    // display itself or the manifest around it.
+    void deserializeSchedule(JsonVariantConst json);
 
     bool serialize(JsonDocument& doc) const;
-    bool deserialize(const JsonDocument& doc);
+    bool deserialize(JsonVariantConst doc);
+
+    // Fills `filter` with the fields deserialize() reads, so the rest of the
+    // response can be skipped while parsing.
+    static void buildFilter(JsonObject filter);
+    static void buildScheduleFilter(JsonObject filter);
 };
 
 #endif // DISPLAY_INFO_H
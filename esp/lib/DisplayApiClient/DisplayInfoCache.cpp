@@ -0,0 +1,59 @@
+#include "DisplayInfoCache.h"
+#include "PlaylistCache.h"
+
+#include <Arduino.h>
+#include <esp_attr.h>
+#include <string.h>
+
+// Raw storage: DisplayInfo has a constructor, which would reset an
+// RTC_DATA_ATTR instance on every boot.
+struct DisplayInfoSlot
+{
+    bool valid;
+    time_t fetchedAt;
+    alignas(DisplayInfo) uint8_t info[sizeof(DisplayInfo)];
+};
+
+RTC_DATA_ATTR static DisplayInfoSlot infoSlot = {};
+
+static const DisplayInfo *cachedInfo()
+{
+    return reinterpret_cast<const DisplayInfo *>(infoSlot.info);
+}
+
+bool DisplayInfoCache::load(int displayId, DisplayInfo &info)
+{
+    if (!infoSlot.valid || cachedInfo()->id != displayId)
+    {
+        return false;
+    }
+    memcpy(static_cast<void *>(&info), infoSlot.info, sizeof(DisplayInfo));
+    return true;
+}
+
+void DisplayInfoCache::store(const DisplayInfo &info, time_t now)
+{
+    memcpy(infoSlot.info, static_cast<const void *>(&info), sizeof(DisplayInfo));
+    infoSlot.fetchedAt = now;
+    infoSlot.valid = true;
+}
+
+bool DisplayInfoCache::isFresh(time_t now)
+{
+    return infoSlot.valid && now >= infoSlot.fetchedAt && now - infoSlot.fetchedAt < DISPLAY_INFO_TTL;
+}
+
+void DisplayInfoCache::expire()
+{
+    infoSlot.fetchedAt = 0;
+}
+
+void DisplayInfoCache::onConfigVersion(int version)
+{
+    if (infoSlot.valid && cachedInfo()->version != version)
+    {
+        Serial.println("Display config changed on the server, expiring cached config.");
+        expire();
+        PlaylistCache::invalidate();
+    }
+}
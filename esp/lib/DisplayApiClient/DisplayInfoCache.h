@@ -0,0 +1,25 @@
+#ifndef DISPLAY_INFO_CACHE_H
+#define DISPLAY_INFO_CACHE_H
+
+#include <time.h>
+#include "DisplayInfo.h"
+
+#ifndef DISPLAY_INFO_TTL
+#define DISPLAY_INFO_TTL 3600 // s
+#endif
+
+// Last fetched DisplayInfo, kept in RTC memory so steady-state wakes do not
+// need to ask the server for a config that almost never changes.
+class DisplayInfoCache
+{
+public:
+    static bool load(int displayId, DisplayInfo &info);
+    static void store(const DisplayInfo &info, time_t now);
+    static bool isFresh(time_t now);
+    // Forces a revalidation on the next lookup, e.g. when a response
+    // advertises a config version different from the cached one.
+    static void expire();
+    static void onConfigVersion(int version);
+};
+
+#endif // DISPLAY_INFO_CACHE_H
@@ -0,0 +1,102 @@
+#ifndef JSON_ARENA_H
+#define JSON_ARENA_H
+
+#include <ArduinoJson.h>
+#include <string.h>
+
+// Fixed-capacity bump allocator for ArduinoJson documents. Every block is
+// served from an inline buffer, so parsing never touches the heap and the
+// whole document is released at once by reset(). Only the most recent block
+// can grow or shrink in place, which is how ArduinoJson uses its string and
+// pool buffers while parsing.
+template <size_t Capacity>
+class JsonArena : public ArduinoJson::Allocator
+{
+private:
+    struct alignas(8) BlockHeader
+    {
+        size_t size;
+    };
+
+    alignas(8) uint8_t buffer[Capacity];
+    size_t used = 0;
+    size_t lastBlock = SIZE_MAX;
+
+    static size_t align(size_t size)
+    {
+        return (size + 7) & ~static_cast<size_t>(7);
+    }
+
+    BlockHeader *header(void *ptr)
+    {
+        return reinterpret_cast<BlockHeader *>(static_cast<uint8_t *>(ptr) - sizeof(BlockHeader));
+    }
+
+    bool isLast(void *ptr)
+    {
+        return lastBlock != SIZE_MAX && static_cast<uint8_t *>(ptr) == buffer + lastBlock + sizeof(BlockHeader);
+    }
+
+public:
+    void *allocate(size_t size) override
+    {
+        size_t needed = sizeof(BlockHeader) + align(size);
+        if (used + needed > Capacity)
+        {
+            return nullptr;
+        }
+        BlockHeader *block = reinterpret_cast<BlockHeader *>(buffer + used);
+        block->size = size;
+        lastBlock = used;
+        used += needed;
+        return block + 1;
+    }
+
+    void deallocate(void *ptr) override
+    {
+        if (ptr != nullptr && isLast(ptr))
+        {
+            used = lastBlock;
+            lastBlock = SIZE_MAX;
+        }
+    }
+
+    void *reallocate(void *ptr, size_t newSize) override
+    {
+        if (ptr == nullptr)
+        {
+            return allocate(newSize);
+        }
+        if (isLast(ptr))
+        {
+            size_t needed = sizeof(BlockHeader) + align(newSize);
+            if (lastBlock + needed > Capacity)
+            {
+                return nullptr;
+            }
+            header(ptr)->size = newSize;
+            used = lastBlock + needed;
+            return ptr;
+        }
+        size_t oldSize = header(ptr)->size;
+        void *moved = allocate(newSize);
+        if (moved != nullptr)
+        {
+            memcpy(moved, ptr, oldSize < newSize ? oldSize : newSize);
+        }
+        return moved;
+    }
+
+    void reset()
+    {
+        used = 0;
+        lastBlock = SIZE_MAX;
+    }
+
+    size_t size() const
+    {
+        return used;
+    }
+};
+
+#endif // JSON_ARENA_H
@@ -0,0 +1,28 @@
+#include "Playlist.h"
+
+Playlist::Playlist() : numFrames(0), validUntil(0) {}
+
+bool Playlist::deserialize(JsonVariantConst doc) {
+    display.deserialize(doc["display"]);
+    numFrames = 0;
+    for (JsonVariantConst entry : doc["frames"].as<JsonArrayConst>()) {
+        if (numFrames >= PLAYLIST_MAX_FRAMES) {
+            break;
+        }
+        frames[numFrames].deserialize(entry);
+        showAt[numFrames] = entry["show_at"] | (time_t)0;
+        if (frames[numFrames].isSet() && frames[numFrames].etag[0] != '\0') {
+            numFrames++;
+        }
+    }
+    validUntil = doc["valid_until"] | (time_t)0;
+    return numFrames > 0;
+}
+
+void Playlist::buildFilter(JsonObject filter) {
+    DisplayInfo::buildFilter(filter["display"].to<JsonObject>());
+    JsonObject frame = filter["frames"].add<JsonObject>();
+    FrameInfo::buildFilter(frame);
+    frame["show_at"] = true;
+    filter["valid_until"] = true;
+}
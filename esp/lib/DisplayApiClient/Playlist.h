@@ -0,0 +1,29 @@
+#ifndef PLAYLIST_H
+#define PLAYLIST_H
+
+#include <ArduinoJson.h>
+#include <time.h>
+#include "DisplayInfo.h"
+#include "WakeManifest.h"
+
+#ifndef PLAYLIST_MAX_FRAMES
+#define PLAYLIST_MAX_FRAMES 8
+#endif
+
+// Upcoming frames of a display, each with the time from which it should be
+// shown, so they can all be downloaded in a single radio session.
+class Playlist {
+public:
+    Playlist();
+
+    DisplayInfo display;
+    FrameInfo frames[PLAYLIST_MAX_FRAMES];
+    time_t showAt[PLAYLIST_MAX_FRAMES];
+    uint8_t numFrames;
+    time_t validUntil;
+
+    bool deserialize(JsonVariantConst doc);
+    static void buildFilter(JsonObject filter);
+};
+
+#endif // PLAYLIST_H
@@ -0,0 +1,82 @@
+#include "PlaylistCache.h"
+
+#include <esp_attr.h>
+#include <string.h>
+
+// What an offline wake needs to draw a frame from FrameCache.
+struct CachedFrame
+{
+    char etag[FRAME_ETAG_SIZE];
+    char format[FRAME_FORMAT_SIZE];
+    uint32_t size;
+    uint16_t cropX;
+    uint16_t cropY;
+    uint16_t cropWidth;
+    uint16_t cropHeight;
+    int16_t x;
+    int16_t y;
+};
+
+struct PlaylistSlot
+{
+    int displayId;
+    time_t validUntil;
+    uint8_t numFrames;
+    CachedFrame frames[PLAYLIST_MAX_FRAMES];
+    time_t showAt[PLAYLIST_MAX_FRAMES];
+};
+
+RTC_DATA_ATTR static PlaylistSlot playlistSlot = {};
+
+void PlaylistCache::store(int displayId, const Playlist &playlist)
+{
+    playlistSlot.displayId = displayId;
+    playlistSlot.validUntil = playlist.validUntil;
+    playlistSlot.numFrames = playlist.numFrames;
+    for (uint8_t i = 0; i < playlist.numFrames; i++)
+    {
+        const FrameInfo &frame = playlist.frames[i];
+        CachedFrame &cached = playlistSlot.frames[i];
+        strlcpy(cached.etag, frame.etag, sizeof(cached.etag));
+        strlcpy(cached.format, frame.format, sizeof(cached.format));
+        cached.size = frame.size;
+        cached.cropX = frame.cropX;
+        cached.cropY = frame.cropY;
+        cached.cropWidth = frame.cropWidth;
+        cached.cropHeight = frame.cropHeight;
+        cached.x = frame.x;
+        cached.y = frame.y;
+        playlistSlot.showAt[i] = playlist.showAt[i];
+    }
+}
+
+bool PlaylistCache::frameAt(int displayId, time_t now, FrameInfo &frame, time_t &nextChange)
+{
+    if (playlistSlot.numFrames == 0 || playlistSlot.displayId != displayId || now >= playlistSlot.validUntil)
+    {
+        return false;
+    }
+    uint8_t index = 0;
+    while (index + 1 < playlistSlot.numFrames && playlistSlot.showAt[index + 1] <= now + PLAYLIST_SHOW_TOLERANCE)
+    {
+        index++;
+    }
+    const CachedFrame &cached = playlistSlot.frames[index];
+    frame = FrameInfo();
+    strlcpy(frame.etag, cached.etag, sizeof(frame.etag));
+    strlcpy(frame.format, cached.format, sizeof(frame.format));
+    frame.size = cached.size;
+    frame.cropX = cached.cropX;
+    frame.cropY = cached.cropY;
+    frame.cropWidth = cached.cropWidth;
+    frame.cropHeight = cached.cropHeight;
+    frame.x = cached.x;
+    frame.y = cached.y;
+    nextChange = index + 1 < playlistSlot.numFrames ? playlistSlot.showAt[index + 1] : playlistSlot.validUntil;
+    return true;
+}
+
+void PlaylistCache::invalidate()
+{
+    playlistSlot.numFrames = 0;
+}
@@ -0,0 +1,24 @@
+#ifndef PLAYLIST_CACHE_H
+#define PLAYLIST_CACHE_H
+
+#include <time.h>
+#include "Playlist.h"
+
+#ifndef PLAYLIST_SHOW_TOLERANCE
+#define PLAYLIST_SHOW_TOLERANCE 5 // s, a frame is due slightly before its time
+#endif
+
+// Schedule of the last fetched playlist, kept in RTC memory. The frames
+// themselves live in FrameCache; only their ETags, formats, crops,
+// positions and times are kept here.
+class PlaylistCache
+{
+public:
+    static void store(int displayId, const Playlist &playlist);
+    // Frame due at `now`, without its URL, and when the following one is,
+    // or when the playlist runs out. False when there is no valid playlist.
+    static bool frameAt(int displayId, time_t now, FrameInfo &frame, time_t &nextChange);
+    static void invalidate();
+};
+
+#endif // PLAYLIST_CACHE_H
@@ -5,7 +5,7 @@ UpdateInfo::UpdateInfo() {}
 UpdateInfo::UpdateInfo(const std::string& message, UpdateStatus status)
     : message(message), status(status) {}
 
-bool UpdateInfo::serialize(JsonDocument& doc) const {
+bool UpdateInfo::serialize(JsonObject doc) const {
     doc["message"] = message;
     switch (status) {
         case UpdateStatus::PASS:
@@ -18,7 +18,7 @@ public:
     std::string message;
     UpdateStatus status;
 
-    bool serialize(JsonDocument& doc) const;
+    bool serialize(JsonObject doc) const;
     bool deserialize(const JsonDocument& doc);
 };
 
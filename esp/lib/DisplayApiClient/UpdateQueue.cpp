@@ -0,0 +1,91 @@
+#include "UpdateQueue.h"
+
+#include <esp_attr.h>
+#include <string.h>
+
+// Before this the RTC clock has not been set, so the age is unknown.
+#define MIN_VALID_TIME 1700000000
+
+struct QueuedUpdate
+{
+    char message[UPDATE_QUEUE_MESSAGE_SIZE];
+    uint8_t status;
+    uint16_t count;  // times queued since the last batch
+    time_t queuedAt; // the last time
+};
+
+struct UpdateRing
+{
+    QueuedUpdate entries[UPDATE_QUEUE_CAPACITY];
+    uint8_t head;
+    uint8_t count;
+    uint32_t dropped;
+};
+
+RTC_DATA_ATTR static UpdateRing ring = {};
+
+void UpdateQueue::push(const UpdateInfo &update, time_t now)
+{
+    char message[UPDATE_QUEUE_MESSAGE_SIZE];
+    strlcpy(message, update.message.c_str(), sizeof(message));
+    for (uint8_t i = 0; i < ring.count; i++)
+    {
+        QueuedUpdate &entry = ring.entries[(ring.head + i) % UPDATE_QUEUE_CAPACITY];
+        if (entry.status == static_cast<uint8_t>(update.status) && strcmp(entry.message, message) == 0)
+        {
+            if (entry.count < UINT16_MAX)
+            {
+                entry.count++;
+            }
+            entry.queuedAt = now;
+            return;
+        }
+    }
+    if (ring.count == UPDATE_QUEUE_CAPACITY)
+    {
+        ring.head = (ring.head + 1) % UPDATE_QUEUE_CAPACITY;
+        ring.count--;
+        ring.dropped++;
+    }
+    QueuedUpdate &entry = ring.entries[(ring.head + ring.count) % UPDATE_QUEUE_CAPACITY];
+    memcpy(entry.message, message, sizeof(entry.message));
+    entry.status = static_cast<uint8_t>(update.status);
+    entry.count = 1;
+    entry.queuedAt = now;
+    ring.count++;
+}
+
+size_t UpdateQueue::size()
+{
+    return ring.count;
+}
+
+uint32_t UpdateQueue::dropped()
+{
+    return ring.dropped;
+}
+
+void UpdateQueue::serialize(JsonDocument &doc, time_t now)
+{
+    JsonArray updates = doc["updates"].to<JsonArray>();
+    for (uint8_t i = 0; i < ring.count; i++)
+    {
+        const QueuedUpdate &entry = ring.entries[(ring.head + i) % UPDATE_QUEUE_CAPACITY];
+        JsonObject json = updates.add<JsonObject>();
+        std::string message = entry.message;
+        if (entry.count > 1)
+        {
+            message += " (x" + std::to_string(entry.count) + ")";
+        }
+        UpdateInfo(message, static_cast<UpdateStatus>(entry.status)).serialize(json);
+        json["age"] = (now >= MIN_VALID_TIME && entry.queuedAt >= MIN_VALID_TIME && now >= entry.queuedAt) ? now - entry.queuedAt : 0;
+    }
+    doc["dropped"] = ring.dropped;
+}
+
+void UpdateQueue::clear()
+{
+    ring.head = 0;
+    ring.count = 0;
+    ring.dropped = 0;
+}
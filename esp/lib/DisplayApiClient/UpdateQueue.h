@@ -0,0 +1,31 @@
+#ifndef UPDATE_QUEUE_H
+#define UPDATE_QUEUE_H
+
+#include <ArduinoJson.h>
+#include <time.h>
+#include "UpdateInfo.h"
+
+#ifndef UPDATE_QUEUE_CAPACITY
+#define UPDATE_QUEUE_CAPACITY 8
+#endif
+
+#define UPDATE_QUEUE_MESSAGE_SIZE 48
+
+// Fixed-size ring of status updates kept in RTC memory. Updates are queued
+// during the wake and sent as a single batch at its end; whatever could not
+// be sent survives deep sleep and goes out with the next batch. An update
+// already queued with the same message and status is counted on its entry,
+// so the routine statuses of offline wakes take one slot each. When the
+// ring is full the oldest entry is overwritten and counted as dropped.
+class UpdateQueue
+{
+public:
+    static void push(const UpdateInfo &update, time_t now);
+    static size_t size();
+    static uint32_t dropped();
+    // Writes the queued entries as {"updates": [...], "dropped": n}.
+    static void serialize(JsonDocument &doc, time_t now);
+    static void clear();
+};
+
+#endif // UPDATE_QUEUE_H
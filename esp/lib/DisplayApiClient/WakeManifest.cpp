@@ -0,0 +1,71 @@
+#include "WakeManifest.h"
+
+FrameInfo::FrameInfo() : size(0), cropX(0), cropY(0), cropWidth(0), cropHeight(0), x(FRAME_DEFAULT_X), y(FRAME_DEFAULT_Y) {
+    url[0] = '\0';
+    format[0] = '\0';
+    etag[0] = '\0';
+}
+
+bool FrameInfo::isSet() const {
+    return url[0] != '\0';
+}
+
+bool FrameInfo::isCropped() const {
+    return cropWidth > 0 && cropHeight > 0;
+}
+
+bool FrameInfo::deserialize(JsonVariantConst json) {
+    strlcpy(url, json["url"] | "", sizeof(url));
+    size = json["size"] | 0;
+    strlcpy(format, json["format"] | "bmp", sizeof(format));
+    strlcpy(etag, json["etag"] | "", sizeof(etag));
+    JsonVariantConst crop = json["crop"];
+    cropX = crop["x"] | 0;
+    cropY = crop["y"] | 0;
+    cropWidth = crop["width"] | 0;
+    cropHeight = crop["height"] | 0;
+    x = json["position"]["x"] | FRAME_DEFAULT_X;
+    y = json["position"]["y"] | FRAME_DEFAULT_Y;
+    return true;
+}
+
+void FrameInfo::buildFilter(JsonObject filter) {
+    filter["url"] = true;
+    filter["size"] = true;
+    filter["format"] = true;
+    filter["etag"] = true;
+    filter["crop"] = true;
+    filter["position"] = true;
+}
+
+WakeManifest::WakeManifest() {}
+
+void WakeManifest::setDisplay(const DisplayInfo& displayInfo) {
+    display = displayInfo;
+    previous = FrameInfo();
+    current = FrameInfo();
+    strlcpy(previous.url, displayInfo.previousUrl, sizeof(previous.url));
+    strlcpy(current.url, displayInfo.url, sizeof(current.url));
+}
+
+bool WakeManifest::deserialize(JsonVariantConst doc) {
+    display.deserialize(doc["display"]);
+    previous = FrameInfo();
+    current = FrameInfo();
+    if (!doc["previous"].isNull()) {
+        previous.deserialize(doc["previous"]);
+    }
+    if (!doc["current"].isNull()) {
+        current.deserialize(doc["current"]);
+    }
+    // The schedule belongs to the current frame, so it sits next to it.
+    display.deserializeSchedule(doc);
+    return current.isSet();
+}
+
+void WakeManifest::buildFilter(JsonObject filter) {
+    DisplayInfo::buildFilter(filter["display"].to<JsonObject>());
+    FrameInfo::buildFilter(filter["previous"].to<JsonObject>());
+    FrameInfo::buildFilter(filter["current"].to<JsonObject>());
+    DisplayInfo::buildScheduleFilter(filter);
+}
@@ -0,0 +1,56 @@
+#ifndef WAKE_MANIFEST_H
+#define WAKE_MANIFEST_H
+
+#include <ArduinoJson.h>
+#include <time.h>
+#include "DisplayInfo.h"
+
+#define FRAME_FORMAT_SIZE 8
+#define FRAME_ETAG_SIZE 41
+// Where frames without a position are drawn.
+#define FRAME_DEFAULT_X 10
+#define FRAME_DEFAULT_Y 10
+
+class FrameInfo {
+public:
+    FrameInfo();
+
+    char url[DISPLAY_INFO_URL_SIZE];
+    uint32_t size;
+    char format[FRAME_FORMAT_SIZE];
+    char etag[FRAME_ETAG_SIZE];
+    // Part of the frame to draw, all of it when cropWidth is 0, and where
+    // its top left corner goes on the panel.
+    uint16_t cropX;
+    uint16_t cropY;
+    uint16_t cropWidth;
+    uint16_t cropHeight;
+    int16_t x;
+    int16_t y;
+
+    bool isSet() const;
+    bool isCropped() const;
+    bool deserialize(JsonVariantConst json);
+    static void buildFilter(JsonObject filter);
+};
+
+// Everything a wake needs from the server: the display config and the
+// frames to draw, resolved by the server so they can be fetched over the
+// same keep-alive connection.
+class WakeManifest {
+public:
+    WakeManifest();
+
+    DisplayInfo display;
+    FrameInfo previous;
+    FrameInfo current;
+
+    // Fallback for servers without a manifest endpoint: the frames are the
+    // raw display URLs, without size or ETag.
+    void setDisplay(const DisplayInfo& displayInfo);
+
+    bool deserialize(JsonVariantConst doc);
+    static void buildFilter(JsonObject filter);
+};
+
+#endif // WAKE_MANIFEST_H
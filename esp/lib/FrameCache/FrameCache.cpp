@@ -0,0 +1,225 @@
+#include "FrameCache.h"
+
+#include <LittleFS.h>
+#include <esp_attr.h>
+
+struct FrameCacheEntry
+{
+    char etag[FRAME_ETAG_SIZE];
+    uint32_t lastUsed;
+};
+
+struct FrameCacheIndex
+{
+    bool valid;
+    uint32_t clock;
+    uint8_t numEntries;
+    FrameCacheEntry entries[FRAME_CACHE_CAPACITY];
+};
+
+RTC_DATA_ATTR static FrameCacheIndex cacheIndex = {};
+static bool mounted = false;
+
+static void framePath(const char *etag, char *path, size_t size, const char *suffix = "")
+{
+    snprintf(path, size, "%s/%s%s", FRAME_CACHE_DIR, etag, suffix);
+}
+
+static int findEntry(const char *etag)
+{
+    for (uint8_t i = 0; i < cacheIndex.numEntries; i++)
+    {
+        if (strcmp(cacheIndex.entries[i].etag, etag) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void addEntry(const char *etag)
+{
+    FrameCacheEntry &entry = cacheIndex.entries[cacheIndex.numEntries++];
+    strlcpy(entry.etag, etag, sizeof(entry.etag));
+    entry.lastUsed = ++cacheIndex.clock;
+}
+
+static void removeEntry(uint8_t index)
+{
+    char path[FRAME_CACHE_PATH_SIZE];
+    framePath(cacheIndex.entries[index].etag, path, sizeof(path));
+    LittleFS.remove(path);
+    Serial.print("Evicted cached frame ");
+    Serial.println(cacheIndex.entries[index].etag);
+    cacheIndex.entries[index] = cacheIndex.entries[--cacheIndex.numEntries];
+}
+
+static bool evictLeastRecentlyUsed()
+{
+    if (cacheIndex.numEntries == 0)
+    {
+        return false;
+    }
+    uint8_t oldest = 0;
+    for (uint8_t i = 1; i < cacheIndex.numEntries; i++)
+    {
+        if (cacheIndex.entries[i].lastUsed < cacheIndex.entries[oldest].lastUsed)
+        {
+            oldest = i;
+        }
+    }
+    removeEntry(oldest);
+    return true;
+}
+
+static size_t freeBytes()
+{
+    size_t total = LittleFS.totalBytes();
+    size_t used = LittleFS.usedBytes();
+    return used < total ? total - used : 0;
+}
+
+// The RTC index is lost on power loss but the files are not: list them back,
+// all equally old, and drop anything unexpected such as interrupted downloads.
+static void rebuildIndex()
+{
+    cacheIndex = {};
+    File dir = LittleFS.open(FRAME_CACHE_DIR);
+    if (!dir || !dir.isDirectory())
+    {
+        LittleFS.mkdir(FRAME_CACHE_DIR);
+    }
+    else
+    {
+        char path[FRAME_CACHE_PATH_SIZE];
+        for (File file = dir.openNextFile(); file; file = dir.openNextFile())
+        {
+            const char *name = file.name();
+            bool keep = strlen(name) == FRAME_ETAG_SIZE - 1 && cacheIndex.numEntries < FRAME_CACHE_CAPACITY;
+            if (keep)
+            {
+                addEntry(name);
+            }
+            framePath(name, path, sizeof(path));
+            file.close();
+            if (!keep)
+            {
+                LittleFS.remove(path);
+            }
+        }
+    }
+    cacheIndex.valid = true;
+    Serial.print("Rebuilt frame cache index with ");
+    Serial.print(cacheIndex.numEntries);
+    Serial.println(" frames");
+}
+
+bool FrameCache::begin()
+{
+    if (!mounted)
+    {
+        mounted = LittleFS.begin(true);
+        if (!mounted)
+        {
+            Serial.println("Could not mount LittleFS, frame cache disabled");
+            return false;
+        }
+    }
+    if (!cacheIndex.valid)
+    {
+        rebuildIndex();
+    }
+    return true;
+}
+
+bool FrameCache::contains(const char *etag)
+{
+    return mounted && etag[0] != '\0' && findEntry(etag) >= 0;
+}
+
+bool FrameCache::find(const char *etag, char *path, size_t size)
+{
+    if (!contains(etag))
+    {
+        return false;
+    }
+    int index = findEntry(etag);
+    framePath(etag, path, size);
+    if (!LittleFS.exists(path))
+    {
+        removeEntry(index);
+        return false;
+    }
+    cacheIndex.entries[index].lastUsed = ++cacheIndex.clock;
+    return true;
+}
+
+bool FrameCache::fetch(HTTPClient &http, ResumableSecureClient &secureClient, const FrameInfo &frame)
+{
+    if (!mounted || frame.etag[0] == '\0')
+    {
+        return false;
+    }
+    int index = findEntry(frame.etag);
+    if (index >= 0)
+    {
+        cacheIndex.entries[index].lastUsed = ++cacheIndex.clock;
+        return true;
+    }
+
+    while (cacheIndex.numEntries >= FRAME_CACHE_CAPACITY || freeBytes() < frame.size + FRAME_CACHE_RESERVE)
+    {
+        if (!evictLeastRecentlyUsed())
+        {
+            Serial.println("Not enough flash to cache frame");
+            return false;
+        }
+    }
+
+    uint32_t startTime = millis();
+    if (!beginRequest(http, secureClient, frame.url))
+    {
+        return false;
+    }
+    int httpCode = http.GET();
+    if (httpCode != HTTP_CODE_OK)
+    {
+        Serial.print("Could not download frame: ");
+        Serial.println(httpCode);
+        http.end();
+        return false;
+    }
+
+    // Written under a temporary name so an interrupted download is never
+    // mistaken for a frame.
+    char tmpPath[FRAME_CACHE_PATH_SIZE];
+    framePath(frame.etag, tmpPath, sizeof(tmpPath), ".tmp");
+    File file = LittleFS.open(tmpPath, "w");
+    int written = file ? http.writeToStream(&file) : -1;
+    file.close();
+    http.end();
+    if (written <= 0 || (frame.size > 0 && (uint32_t)written != frame.size))
+    {
+        Serial.print("Frame download failed: ");
+        Serial.println(written);
+        LittleFS.remove(tmpPath);
+        return false;
+    }
+
+    char path[FRAME_CACHE_PATH_SIZE];
+    framePath(frame.etag, path, sizeof(path));
+    if (!LittleFS.rename(tmpPath, path))
+    {
+        LittleFS.remove(tmpPath);
+        return false;
+    }
+    addEntry(frame.etag);
+    Serial.print("Cached frame ");
+    Serial.print(frame.etag);
+    Serial.print(" (");
+    Serial.print(written);
+    Serial.print(" bytes) in ");
+    Serial.print(millis() - startTime);
+    Serial.println(" ms");
+    return true;
+}
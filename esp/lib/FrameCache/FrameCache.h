@@ -0,0 +1,34 @@
+#ifndef FRAME_CACHE_H
+#define FRAME_CACHE_H
+
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <ResumableSecureClient.h>
+#include <WakeManifest.h>
+
+#define FRAME_CACHE_DIR "/frames"
+#define FRAME_CACHE_PATH_SIZE (sizeof(FRAME_CACHE_DIR) + FRAME_ETAG_SIZE + 4)
+
+#ifndef FRAME_CACHE_CAPACITY
+#define FRAME_CACHE_CAPACITY 12
+#endif
+
+#ifndef FRAME_CACHE_RESERVE
+#define FRAME_CACHE_RESERVE 16384 // bytes kept free on the filesystem
+#endif
+
+// Frames stored on LittleFS under their ETag, evicted least recently used
+// first when the count or the free space runs out. The recency index lives
+// in RTC memory and is rebuilt from the directory after a power loss.
+class FrameCache
+{
+public:
+    static bool begin();
+    static bool contains(const char *etag);
+    // Path of a cached frame, marked as used. False on a cache miss.
+    static bool find(const char *etag, char *path, size_t size);
+    // Downloads `frame` over `http` unless it is already cached.
+    static bool fetch(HTTPClient &http, ResumableSecureClient &secureClient, const FrameInfo &frame);
+};
+
+#endif // FRAME_CACHE_H
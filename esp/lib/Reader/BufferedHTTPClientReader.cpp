@@ -2,7 +2,11 @@
 #include <stdexcept>
 #include <format>
 
-BufferedHTTPClientReader::BufferedHTTPClientReader(const char *url, size_t bufferSize, uint16_t timeout, uint16_t numRetries, uint16_t retryDelay) : url(url), bufferSize(bufferSize), bufferPos(0), bufferFill(0), timeout(timeout), pos(0), numRetries(numRetries), retryDelay(retryDelay)
+BufferedHTTPClientReader::BufferedHTTPClientReader(const char *url, size_t bufferSize, uint16_t timeout, uint16_t numRetries, uint16_t retryDelay) : BufferedHTTPClientReader(ownClient, ownSecureClient, url, bufferSize, timeout, numRetries, retryDelay)
+{
+}
+
+BufferedHTTPClientReader::BufferedHTTPClientReader(HTTPClient &client, ResumableSecureClient &secureClient, const char *url, size_t bufferSize, uint16_t timeout, uint16_t numRetries, uint16_t retryDelay) : client(client), secureClient(secureClient), stream(nullptr), url(url), bufferSize(bufferSize), bufferPos(0), bufferFill(0), timeout(timeout), pos(0), size(0), numRetries(numRetries), retryDelay(retryDelay)
 {
     buffer = new uint8_t[bufferSize];
     connect();
@@ -11,16 +15,28 @@ BufferedHTTPClientReader::BufferedHTTPClientReader(const char *url, size_t buffe
 BufferedHTTPClientReader::~BufferedHTTPClientReader()
 {
     delete[] buffer;
-    client.end();
+    end();
 }
 
-void BufferedHTTPClientReader::connect()
+void BufferedHTTPClientReader::end()
 {
+    // HTTPClient keeps a reused connection after draining what has arrived,
+    // the rest of an unread body would then be parsed as the next response.
+    bool received = size > 0 && pos + (bufferFill - bufferPos) >= size;
+    if (stream != nullptr && !received)
+    {
+        stream->stop();
+    }
+    stream = nullptr;
     client.end();
+}
+
+void BufferedHTTPClientReader::connect(size_t from)
+{
+    end();
     pos = 0;
     bufferPos = 0;
     bufferFill = 0;
-    stream = nullptr;
 
     int retries = 0;
     while (retries <= numRetries)
@@ -35,15 +51,26 @@ void BufferedHTTPClientReader::connect()
             errorMessage += " retries.";
             throw std::runtime_error(errorMessage);
         }
-        if (!client.begin(url))
+        if (!beginRequest(client, secureClient, url))
         {
             Serial.print("Connection failed, retrying...");
             retries++;
             delay(retryDelay);
             continue;
         }
+        if (from > 0)
+        {
+            char range[24];
+            snprintf(range, sizeof(range), "bytes=%u-", (unsigned)from);
+            client.addHeader("Range", range);
+        }
         int returnCode = client.GET();
         if (returnCode == HTTP_CODE_OK)
+        {
+            from = 0;
+            break;
+        }
+        if (returnCode == HTTP_CODE_PARTIAL_CONTENT && from > 0)
         {
             break;
         }
@@ -59,6 +86,9 @@ void BufferedHTTPClientReader::connect()
     }
 
     stream = client.getStreamPtr();
+    int contentLength = client.getSize();
+    size = contentLength > 0 ? from + contentLength : 0;
+    pos = from;
 }
 
 size_t BufferedHTTPClientReader::getPos()
@@ -66,6 +96,11 @@ size_t BufferedHTTPClientReader::getPos()
     return pos;
 }
 
+size_t BufferedHTTPClientReader::getSize()
+{
+    return size;
+}
+
 uint8_t BufferedHTTPClientReader::read()
 {
     if (bufferPos == bufferFill)
@@ -126,24 +161,26 @@ uint32_t BufferedHTTPClientReader::read32()
 
 size_t BufferedHTTPClientReader::readBytes(uint8_t *buffer, size_t length)
 {
+    // Drains the buffer first: the stream may already be empty while
+    // buffered bytes are left. read() refills it and keeps `pos`.
     size_t bytesRead = 0;
-    uint32_t start = millis();
-    while ((stream->connected() || stream->available()) && (bytesRead < length))
+    while (bytesRead < length)
     {
-        if (stream->available())
+        if (bufferPos == bufferFill && size > 0 && pos >= size)
         {
-            *buffer++ = read();
-            bytesRead++;
-            pos++;
-        }
-        else
-        {
-            delay(1);
+            break;
         }
-        if (millis() - start > 2000)
+        size_t buffered = bufferFill - bufferPos;
+        if (buffered == 0)
         {
-            break;
+            buffer[bytesRead++] = read();
+            continue;
         }
+        size_t chunk = min(buffered, length - bytesRead);
+        memcpy(buffer + bytesRead, this->buffer + bufferPos, chunk);
+        bufferPos += chunk;
+        pos += chunk;
+        bytesRead += chunk;
     }
     return bytesRead;
 }
@@ -160,9 +197,15 @@ boolean BufferedHTTPClientReader::seek(size_t newPos)
         Serial.println("Error: new position is negative");
         return false;
     }
-    if (newPos < pos)
+    if (newPos < pos && pos - newPos <= bufferPos)
+    {
+        // Still buffered, e.g. after sniffing the format of the frame.
+        bufferPos -= pos - newPos;
+        pos = newPos;
+    }
+    else if (newPos < pos || newPos - pos > bufferFill - bufferPos + HTTP_READER_RANGE_THRESHOLD)
     {
-        connect();
+        connect(newPos);
     }
     while (pos < newPos)
     {
@@ -3,11 +3,19 @@
 
 #include <HTTPClient.h>
 #include <Reader.h>
+#include <ResumableSecureClient.h>
+
+// Forward seeks further than this past the buffered bytes are served by a
+// new request for the remaining bytes instead of reading through them.
+#define HTTP_READER_RANGE_THRESHOLD 8192
 
 class BufferedHTTPClientReader : public Reader
 {
 private:
-    HTTPClient client;
+    HTTPClient ownClient;
+    ResumableSecureClient ownSecureClient;
+    HTTPClient &client;
+    ResumableSecureClient &secureClient;
     NetworkClient *stream;
     const char *url;
     const uint16_t timeout;
@@ -18,19 +26,29 @@ private:
     size_t bufferPos;
     size_t bufferFill;
     size_t pos;
+    size_t size;
+
+    // Ends the request, closing the connection when the body is not fully
+    // received.
+    void end();
 
 public:
     BufferedHTTPClientReader(const char *url, size_t bufferSize, uint16_t timeout = 5000, uint16_t numRetries = 5, uint16_t retryDelay = 500);
+    // Reads over an existing (keep-alive) connection instead of opening one.
+    BufferedHTTPClientReader(HTTPClient &client, ResumableSecureClient &secureClient, const char *url, size_t bufferSize, uint16_t timeout = 5000, uint16_t numRetries = 5, uint16_t retryDelay = 500);
     ~BufferedHTTPClientReader();
 
     size_t getPos() override;
+    size_t getSize() override;
     uint8_t read() override;
     uint16_t read16() override;
     uint32_t read32() override;
     size_t readBytes(uint8_t *buffer, size_t length) override;
     boolean seek(size_t newPos) override;
     bool isConnectedAndavailable();
-    void connect();
+    // Requests the data from byte `from` on. Servers without Range support
+    // answer with the whole body, which is then read up to `from`.
+    void connect(size_t from = 0);
 };
 
 #endif
@@ -15,6 +15,11 @@ size_t FileSystemReader::getPos()
     return pos;
 }
 
+size_t FileSystemReader::getSize()
+{
+    return file ? file.size() : 0;
+}
+
 uint8_t FileSystemReader::read()
 {
     ++pos;
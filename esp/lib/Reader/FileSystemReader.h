@@ -16,6 +16,7 @@ public:
     FileSystemReader(fs::FS &fs, const char *filename);
     ~FileSystemReader();
     size_t getPos() override;
+    size_t getSize() override;
     uint8_t read() override;
     uint16_t read16() override;
     uint32_t read32() override;
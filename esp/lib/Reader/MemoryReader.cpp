@@ -0,0 +1,98 @@
+#include "MemoryReader.h"
+
+MemoryReader::MemoryReader() : data(nullptr), size(0), pos(0) {}
+
+MemoryReader::~MemoryReader()
+{
+    release();
+}
+
+bool MemoryReader::fits(size_t size)
+{
+    return size > 0 && ESP.getMaxAllocHeap() >= size + MEMORY_READER_HEAP_RESERVE;
+}
+
+bool MemoryReader::load(Reader &source, size_t size)
+{
+    release();
+    if (!fits(size))
+    {
+        return false;
+    }
+    data = (uint8_t *)malloc(size);
+    if (data == nullptr)
+    {
+        return false;
+    }
+    if (source.readBytes(data, size) != size)
+    {
+        release();
+        return false;
+    }
+    this->size = size;
+    return true;
+}
+
+bool MemoryReader::isLoaded() const
+{
+    return data != nullptr;
+}
+
+void MemoryReader::release()
+{
+    free(data);
+    data = nullptr;
+    size = 0;
+    pos = 0;
+}
+
+size_t MemoryReader::getPos()
+{
+    return pos;
+}
+
+size_t MemoryReader::getSize()
+{
+    return size;
+}
+
+uint8_t MemoryReader::read()
+{
+    return pos < size ? data[pos++] : 0;
+}
+
+uint16_t MemoryReader::read16()
+{
+    uint16_t result;
+    ((uint8_t *)&result)[0] = read(); // LSB
+    ((uint8_t *)&result)[1] = read(); // MSB
+    return result;
+}
+
+uint32_t MemoryReader::read32()
+{
+    uint32_t result;
+    ((uint8_t *)&result)[0] = read(); // LSB
+    ((uint8_t *)&result)[1] = read();
+    ((uint8_t *)&result)[2] = read();
+    ((uint8_t *)&result)[3] = read(); // MSB
+    return result;
+}
+
+size_t MemoryReader::readBytes(uint8_t *buffer, size_t length)
+{
+    size_t numBytesRead = min(length, size - pos);
+    memcpy(buffer, data + pos, numBytesRead);
+    pos += numBytesRead;
+    return numBytesRead;
+}
+
+boolean MemoryReader::seek(size_t newPos)
+{
+    if (newPos > size)
+    {
+        return false;
+    }
+    pos = newPos;
+    return true;
+}
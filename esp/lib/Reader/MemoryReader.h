@@ -0,0 +1,40 @@
+#ifndef MEMORY_READER_H
+#define MEMORY_READER_H
+
+#include "Reader.h"
+
+// Heap left to the decoders and the TLS client after a frame is buffered.
+#define MEMORY_READER_HEAP_RESERVE 49152
+
+// Reader over a copy of the data held in RAM, so it can be drawn once the
+// radio is off.
+class MemoryReader : public Reader
+{
+private:
+    uint8_t *data;
+    size_t size;
+    size_t pos;
+
+public:
+    MemoryReader();
+    ~MemoryReader();
+
+    // Whether `size` bytes can be buffered with MEMORY_READER_HEAP_RESERVE
+    // bytes of heap to spare.
+    static bool fits(size_t size);
+    // Copies the `size` bytes `source` has left. Fails without touching the
+    // heap when they do not fit.
+    bool load(Reader &source, size_t size);
+    bool isLoaded() const;
+    void release();
+
+    size_t getPos() override;
+    size_t getSize() override;
+    uint8_t read() override;
+    uint16_t read16() override;
+    uint32_t read32() override;
+    size_t readBytes(uint8_t *buffer, size_t length) override;
+    boolean seek(size_t newPos) override;
+};
+
+#endif // MEMORY_READER_H
@@ -7,6 +7,8 @@ class Reader
 {
 public:
     virtual size_t getPos();
+    // Total length of the data, 0 when unknown.
+    virtual size_t getSize();
     virtual uint8_t read();
     virtual uint16_t read16();
     virtual uint32_t read32();
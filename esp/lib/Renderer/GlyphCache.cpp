@@ -0,0 +1,221 @@
+#include <GlyphCache.h>
+
+// Layout of the u8g2 font header, see u8g2_font.c.
+#define FONT_HEADER_SIZE 23
+#define FONT_BITS_PER_0 2
+#define FONT_BITS_PER_1 3
+#define FONT_BITS_PER_WIDTH 4
+#define FONT_BITS_PER_HEIGHT 5
+#define FONT_BITS_PER_X 6
+#define FONT_BITS_PER_Y 7
+#define FONT_BITS_PER_DELTA 8
+#define FONT_ASCENT 13
+#define FONT_DESCENT 14
+#define FONT_START_UPPER_A 17
+#define FONT_START_LOWER_A 19
+
+struct FontGlyphs
+{
+    const uint8_t *font;
+    Glyph glyphs[GLYPH_CACHE_CODEPOINTS];
+};
+
+static FontGlyphs fonts[GLYPH_CACHE_FONTS];
+static uint8_t numFonts = 0;
+static uint8_t pool[GLYPH_CACHE_POOL_SIZE];
+static uint16_t poolUsed = 0;
+
+// Reads the LSB first bit fields of a glyph.
+class GlyphBits
+{
+private:
+    const uint8_t *data;
+    uint8_t bitPos;
+
+public:
+    GlyphBits(const uint8_t *data) : data(data), bitPos(0) {}
+
+    uint8_t readUnsigned(uint8_t count)
+    {
+        uint16_t value = *data >> bitPos;
+        uint8_t end = bitPos + count;
+        if (end >= 8)
+        {
+            data++;
+            value |= (uint16_t)*data << (8 - bitPos);
+            end -= 8;
+        }
+        bitPos = end;
+        return value & ((1 << count) - 1);
+    }
+
+    int8_t readSigned(uint8_t count)
+    {
+        return (int8_t)readUnsigned(count) - (1 << (count - 1));
+    }
+};
+
+static const uint8_t *findGlyphData(const uint8_t *font, uint16_t codepoint)
+{
+    if (codepoint >= GLYPH_CACHE_CODEPOINTS)
+    {
+        return nullptr;
+    }
+    const uint8_t *data = font + FONT_HEADER_SIZE;
+    if (codepoint >= 'a')
+    {
+        data += (font[FONT_START_LOWER_A] << 8) | font[FONT_START_LOWER_A + 1];
+    }
+    else if (codepoint >= 'A')
+    {
+        data += (font[FONT_START_UPPER_A] << 8) | font[FONT_START_UPPER_A + 1];
+    }
+    // Glyphs below 256 are stored as (encoding, size of the glyph record).
+    while (data[1] != 0)
+    {
+        if (data[0] == codepoint)
+        {
+            return data + 2;
+        }
+        data += data[1];
+    }
+    return nullptr;
+}
+
+static bool decodeGlyph(const uint8_t *font, const uint8_t *data, Glyph &glyph)
+{
+    GlyphBits bits(data);
+    glyph.width = bits.readUnsigned(font[FONT_BITS_PER_WIDTH]);
+    glyph.height = bits.readUnsigned(font[FONT_BITS_PER_HEIGHT]);
+    glyph.x = bits.readSigned(font[FONT_BITS_PER_X]);
+    glyph.y = bits.readSigned(font[FONT_BITS_PER_Y]);
+    glyph.advance = bits.readSigned(font[FONT_BITS_PER_DELTA]);
+
+    uint16_t rowBytes = (glyph.width + 7) / 8;
+    uint16_t size = rowBytes * glyph.height;
+    if (poolUsed + size > GLYPH_CACHE_POOL_SIZE)
+    {
+        return false;
+    }
+    glyph.bitmap = poolUsed;
+    poolUsed += size;
+    uint8_t *bitmap = pool + glyph.bitmap;
+    memset(bitmap, 0, size);
+
+    // Runs of zeros then ones, each pair repeated while the next bit is set,
+    // wrapping from one row to the next.
+    uint8_t x = 0;
+    uint8_t y = 0;
+    while (glyph.width > 0 && y < glyph.height)
+    {
+        uint8_t zeros = bits.readUnsigned(font[FONT_BITS_PER_0]);
+        uint8_t ones = bits.readUnsigned(font[FONT_BITS_PER_1]);
+        do
+        {
+            for (uint8_t i = 0; i < zeros + ones && y < glyph.height; i++)
+            {
+                if (i >= zeros)
+                {
+                    bitmap[y * rowBytes + x / 8] |= 0x80 >> (x % 8);
+                }
+                if (++x == glyph.width)
+                {
+                    x = 0;
+                    y++;
+                }
+            }
+        } while (bits.readUnsigned(1) != 0 && y < glyph.height);
+    }
+    glyph.decoded = true;
+    return true;
+}
+
+static FontGlyphs *glyphsOf(const uint8_t *font)
+{
+    for (uint8_t i = 0; i < numFonts; i++)
+    {
+        if (fonts[i].font == font)
+        {
+            return &fonts[i];
+        }
+    }
+    if (numFonts == GLYPH_CACHE_FONTS)
+    {
+        GlyphCache::clear();
+    }
+    FontGlyphs &entry = fonts[numFonts++];
+    entry.font = font;
+    memset(entry.glyphs, 0, sizeof(entry.glyphs));
+    return &entry;
+}
+
+const Glyph *GlyphCache::get(const uint8_t *font, uint16_t codepoint)
+{
+    if (codepoint >= GLYPH_CACHE_CODEPOINTS)
+    {
+        return nullptr;
+    }
+    Glyph *glyph = &glyphsOf(font)->glyphs[codepoint];
+    if (glyph->decoded)
+    {
+        return glyph;
+    }
+    const uint8_t *data = findGlyphData(font, codepoint);
+    if (data == nullptr)
+    {
+        return nullptr;
+    }
+    if (!decodeGlyph(font, data, *glyph))
+    {
+        // Pool full: start over, the glyphs in use are decoded again.
+        clear();
+        glyph = &glyphsOf(font)->glyphs[codepoint];
+        if (!decodeGlyph(font, data, *glyph))
+        {
+            return nullptr;
+        }
+    }
+    return glyph;
+}
+
+const uint8_t *GlyphCache::bitmap(const Glyph &glyph)
+{
+    return pool + glyph.bitmap;
+}
+
+int8_t GlyphCache::ascent(const uint8_t *font)
+{
+    return (int8_t)font[FONT_ASCENT];
+}
+
+int8_t GlyphCache::descent(const uint8_t *font)
+{
+    return (int8_t)font[FONT_DESCENT];
+}
+
+void GlyphCache::clear()
+{
+    numFonts = 0;
+    poolUsed = 0;
+}
+
+uint16_t nextCodepoint(const char *&text)
+{
+    uint8_t lead = *text;
+    if (lead == 0)
+    {
+        return 0;
+    }
+    text++;
+    if (lead < 0x80)
+    {
+        return lead;
+    }
+    uint8_t continuations = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : 0;
+    uint32_t codepoint = lead & (0x3F >> continuations);
+    for (uint8_t i = 0; i < continuations && (*text & 0xC0) == 0x80; i++)
+    {
+        codepoint = (codepoint << 6) | (*text++ & 0x3F);
+    }
+    return codepoint <= UINT16_MAX ? codepoint : UINT16_MAX;
+}
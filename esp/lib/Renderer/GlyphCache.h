@@ -0,0 +1,43 @@
+#ifndef __GLYPH_CACHE_H__
+#define __GLYPH_CACHE_H__
+
+#include <Arduino.h>
+
+#ifndef GLYPH_CACHE_FONTS
+#define GLYPH_CACHE_FONTS 3
+#endif
+
+#ifndef GLYPH_CACHE_POOL_SIZE
+#define GLYPH_CACHE_POOL_SIZE 16384 // bytes of decoded glyph bitmaps
+#endif
+
+#define GLYPH_CACHE_CODEPOINTS 256 // the _tf fonts cover Latin-1
+
+struct Glyph
+{
+    uint16_t bitmap; // offset in the pool, rows of (width + 7) / 8 bytes, MSB first
+    uint8_t width;
+    uint8_t height;
+    int8_t x;        // from the pen position
+    int8_t y;        // from the baseline to the bottom of the bitmap
+    int8_t advance;
+    bool decoded;
+};
+
+// Glyphs of u8g2 fonts decoded once from their run-length encoding into
+// 1bpp row-aligned bitmaps, so drawing text only copies bits around.
+class GlyphCache
+{
+public:
+    // Null when the font has no glyph for `codepoint`.
+    static const Glyph *get(const uint8_t *font, uint16_t codepoint);
+    static const uint8_t *bitmap(const Glyph &glyph);
+    static int8_t ascent(const uint8_t *font);
+    static int8_t descent(const uint8_t *font);
+    static void clear();
+};
+
+// Next code point of a UTF-8 string, advancing `text`. 0 at its end.
+uint16_t nextCodepoint(const char *&text);
+
+#endif
@@ -0,0 +1,317 @@
+#include <Renderer.h>
+
+Renderer::Renderer(Display &display) : display(display)
+{
+}
+
+// The _tf fonts only cover Latin-1, which has no ellipsis glyph.
+static const char ellipsis[] = "...";
+
+uint16_t Renderer::getStringWidth(const char *text, const uint8_t *font)
+{
+  // FNV-1a over the font pointer and the bytes of the string.
+  uint32_t hash = 2166136261u ^ (uint32_t)(uintptr_t)font;
+  uint16_t length = 0;
+  for (const char *c = text; *c != '\0'; c++, length++)
+  {
+    hash = (hash ^ (uint8_t)*c) * 16777619u;
+  }
+  WidthCacheEntry &cached = widthCache[hash % RENDERER_WIDTH_CACHE_SIZE];
+  if (cached.font != font || cached.hash != hash || cached.length != length)
+  {
+    cached = {font, hash, length, measureString(text, font)};
+  }
+  return cached.width;
+}
+
+uint16_t Renderer::measureString(const char *text, const uint8_t *font)
+{
+  uint16_t width = 0;
+  for (uint16_t codepoint = nextCodepoint(text); codepoint != 0; codepoint = nextCodepoint(text))
+  {
+    const Glyph *glyph = GlyphCache::get(font, codepoint);
+    if (glyph != nullptr)
+    {
+      width += glyph->advance;
+    }
+  }
+  return width;
+}
+
+uint16_t Renderer::getStringWidth(const String &text, const uint8_t *font)
+{
+  return getStringWidth(text.c_str(), font);
+}
+
+uint16_t Renderer::getStringWidth(const String &text)
+{
+  return getStringWidth(text.c_str(), defaultFont);
+}
+
+uint16_t Renderer::getStringHeight(const char *text, const uint8_t *font)
+{
+  int16_t height = GlyphCache::ascent(font);
+  if (hasDescender(text))
+  {
+    height -= GlyphCache::descent(font);
+  }
+  return height;
+}
+
+uint16_t Renderer::getStringHeight(const String &text, const uint8_t *font)
+{
+  return getStringHeight(text.c_str(), font);
+}
+
+uint16_t Renderer::getStringHeight(const String &text)
+{
+  return getStringHeight(text.c_str(), defaultFont);
+}
+
+void Renderer::getStringBounds(Bounds &bounds, int16_t x, int16_t y, const char *text, const uint8_t *font, horizontal_alignment_t horizontal_alignment, vertical_alignment_t vertical_alignment)
+{
+  bounds.w = getStringWidth(text, font);
+  bounds.h = getStringHeight(text, font);
+  switch (horizontal_alignment)
+  {
+  case RIGHT:
+    bounds.x = x - bounds.w;
+    break;
+  case CENTER:
+    bounds.x = x - bounds.w / 2;
+    break;
+  default:
+    bounds.x = x;
+  }
+  switch (vertical_alignment)
+  {
+  case BOTTOM:
+    bounds.y = y - bounds.h;
+    break;
+  case MIDDLE:
+    bounds.y = y - bounds.h / 2;
+    break;
+  default:
+    bounds.y = y;
+  }
+}
+
+void Renderer::getStringBounds(Bounds &bounds, int16_t x, int16_t y, const String &text, const uint8_t *font, horizontal_alignment_t horizontal_alignment, vertical_alignment_t vertical_alignment)
+{
+  getStringBounds(bounds, x, y, text.c_str(), font, horizontal_alignment, vertical_alignment);
+}
+
+void Renderer::getStringBounds(Bounds &bounds, int16_t x, int16_t y, const String &text, horizontal_alignment_t horizontal_alignment, vertical_alignment_t vertical_alignment)
+{
+  getStringBounds(bounds, x, y, text.c_str(), defaultFont, horizontal_alignment, vertical_alignment);
+}
+
+void Renderer::drawString(int16_t x, int16_t y, const char *text, const uint8_t *font, uint16_t color, horizontal_alignment_t horizontal_alignment, vertical_alignment_t vertical_alignment)
+{
+  Bounds bounds;
+  getStringBounds(bounds, x, y, text, font, horizontal_alignment, vertical_alignment);
+  // Glyphs are placed from the baseline, the bounds start at the top of the ascent.
+  int16_t baseline = bounds.y + GlyphCache::ascent(font);
+  int16_t penX = bounds.x;
+  for (uint16_t codepoint = nextCodepoint(text); codepoint != 0; codepoint = nextCodepoint(text))
+  {
+    const Glyph *glyph = GlyphCache::get(font, codepoint);
+    if (glyph == nullptr)
+    {
+      continue;
+    }
+    drawGlyph(*glyph, penX + glyph->x, baseline - (glyph->height + glyph->y), color);
+    penX += glyph->advance;
+  }
+}
+
+void Renderer::drawGlyph(const Glyph &glyph, int16_t x, int16_t y, uint16_t color)
+{
+  // GxEPD2 drops pixels outside the current page one by one, skip those rows
+  // and glyphs up front.
+  int16_t pageX, pageY, pageWidth, pageHeight;
+  display.pageBounds(pageX, pageY, pageWidth, pageHeight);
+  if (x + glyph.width <= pageX || x >= pageX + pageWidth)
+  {
+    return;
+  }
+  int16_t pageTop = pageY;
+  int16_t pageBottom = pageY + pageHeight;
+  uint8_t rowBytes = (glyph.width + 7) / 8;
+  const uint8_t *row = GlyphCache::bitmap(glyph);
+  for (uint8_t r = 0; r < glyph.height; r++, row += rowBytes)
+  {
+    int16_t rowY = y + r;
+    if (rowY < pageTop || rowY >= pageBottom)
+    {
+      continue;
+    }
+    // Every run of set bits is filled into the page buffer as one line.
+    uint8_t col = 0;
+    while (col < glyph.width)
+    {
+      uint8_t bits = row[col / 8] << (col % 8);
+      if (bits == 0)
+      {
+        col = (col / 8 + 1) * 8;
+        continue;
+      }
+      col += __builtin_clz((uint32_t)bits << 24);
+      uint8_t start = col;
+      while (col < glyph.width && (row[col / 8] & (0x80 >> (col % 8))))
+      {
+        col++;
+      }
+      display.drawFastHLine(x + start, rowY, col - start, color);
+    }
+  }
+}
+
+void Renderer::drawString(int16_t x, int16_t y, const String &text, const uint8_t *font, uint16_t color, horizontal_alignment_t horizontal_alignment, vertical_alignment_t vertical_alignment)
+{
+  drawString(x, y, text.c_str(), font, color, horizontal_alignment, vertical_alignment);
+}
+
+void Renderer::drawString(int16_t x, int16_t y, const String &text, uint16_t color, horizontal_alignment_t horizontal_alignment, vertical_alignment_t vertical_alignment)
+{
+  drawString(x, y, text.c_str(), defaultFont, color, horizontal_alignment, vertical_alignment);
+}
+
+void Renderer::drawCheckboard(const Bounds &bounds, uint16_t squareSize, uint16_t color1, uint16_t color2)
+{
+  if (squareSize == 1)
+  {
+    // Rows of alternating colors, every row one pixel along the last.
+    uint16_t *pattern = new uint16_t[bounds.w + 1];
+    for (uint16_t col = 0; col <= bounds.w; col++)
+    {
+      pattern[col] = col % 2 ? color2 : color1;
+    }
+    for (uint16_t row = 0; row < bounds.h; row++)
+    {
+      display.drawRow(bounds.x, bounds.y + row, pattern + row % 2, bounds.w);
+    }
+    display.flushRows();
+    delete[] pattern;
+    return;
+  }
+  // One fill for the first color, then only the squares of the second.
+  display.fillRect(bounds.x, bounds.y, bounds.w, bounds.h, color1);
+  for (uint16_t row = 0; row * squareSize < bounds.h; row++)
+  {
+    for (uint16_t col = (row + 1) % 2; col * squareSize < bounds.w; col += 2)
+    {
+      uint16_t w = min<uint16_t>(squareSize, bounds.w - col * squareSize);
+      uint16_t h = min<uint16_t>(squareSize, bounds.h - row * squareSize);
+      display.fillRect(bounds.x + col * squareSize, bounds.y + row * squareSize, w, h, color2);
+    }
+  }
+}
+
+void Renderer::drawBounds(const Bounds &bounds, uint16_t color)
+{
+  if (bounds.w == 0 || bounds.h == 0)
+  {
+    return;
+  }
+  display.drawFastHLine(bounds.x, bounds.y, bounds.w, color);
+  display.drawFastHLine(bounds.x, bounds.y + bounds.h - 1, bounds.w, color);
+  display.fillRect(bounds.x, bounds.y, 1, bounds.h, color);
+  display.fillRect(bounds.x + bounds.w - 1, bounds.y, 1, bounds.h, color);
+}
+
+bool Renderer::hasDescender(const char *text)
+{
+  return strpbrk(text, "gjpqyQ,;()[]{}|_@$") != nullptr;
+}
+
+bool Renderer::hasDescender(const String &text)
+{
+  return hasDescender(text.c_str());
+}
+
+size_t Renderer::getPrefixWidths(const char *text, const uint8_t *font, uint16_t *offsets, uint16_t *widths, size_t capacity)
+{
+  const char *cursor = text;
+  uint16_t width = 0;
+  size_t count = 0;
+  while (count < capacity)
+  {
+    offsets[count] = cursor - text;
+    widths[count] = width;
+    count++;
+    uint16_t codepoint = nextCodepoint(cursor);
+    if (codepoint == 0)
+    {
+      break;
+    }
+    const Glyph *glyph = GlyphCache::get(font, codepoint);
+    if (glyph != nullptr)
+    {
+      width += glyph->advance;
+    }
+  }
+  return count;
+}
+
+size_t Renderer::fitPrefix(const char *text, uint16_t width, const uint8_t *font, bool &truncated)
+{
+  uint16_t offsets[RENDERER_MAX_PREFIXES];
+  uint16_t widths[RENDERER_MAX_PREFIXES];
+  size_t count = getPrefixWidths(text, font, offsets, widths, RENDERER_MAX_PREFIXES);
+  size_t length = offsets[count - 1];
+  truncated = text[length] != '\0' || widths[count - 1] > width;
+  if (!truncated)
+  {
+    return length;
+  }
+  // Prefix widths never decrease, so the longest one that fits is found by
+  // bisection. The empty prefix always fits.
+  uint16_t ellipsisWidth = getStringWidth(ellipsis, font);
+  uint16_t available = width > ellipsisWidth ? width - ellipsisWidth : 0;
+  size_t low = 0;
+  size_t high = count - 1;
+  while (low < high)
+  {
+    size_t middle = (low + high + 1) / 2;
+    if (widths[middle] <= available)
+    {
+      low = middle;
+    }
+    else
+    {
+      high = middle - 1;
+    }
+  }
+  return offsets[low];
+}
+
+void Renderer::ellipsize(const char *text, uint16_t width, const uint8_t *font, char *buffer, size_t size)
+{
+  bool truncated;
+  size_t length = fitPrefix(text, width, font, truncated);
+  ellipsize(text, length, truncated, buffer, size);
+}
+
+void Renderer::ellipsize(const char *text, size_t length, bool truncated, char *buffer, size_t size)
+{
+  size_t reserved = truncated ? sizeof(ellipsis) : 1;
+  if (length + reserved > size)
+  {
+    length = size > reserved ? size - reserved : 0;
+    // Drop a whole UTF-8 sequence, not just its last bytes.
+    while (length > 0 && (text[length] & 0xC0) == 0x80)
+    {
+      length--;
+    }
+  }
+  memcpy(buffer, text, length);
+  if (truncated)
+  {
+    memcpy(buffer + length, ellipsis, sizeof(ellipsis));
+  }
+  else
+  {
+    buffer[length] = '\0';
+  }
+}
@@ -0,0 +1,89 @@
+#ifndef __RENDERER_H__
+#define __RENDERER_H__
+#include <Arduino.h>
+
+#include <Display.h>
+#include <GlyphCache.h>
+#include <U8g2_for_Adafruit_GFX.h>
+
+#ifndef RENDERER_WIDTH_CACHE_SIZE
+#define RENDERER_WIDTH_CACHE_SIZE 64 // measured strings
+#endif
+
+#define RENDERER_MAX_PREFIXES 64 // code points measured by ellipsize
+
+typedef enum horzional_alignment
+{
+  LEFT,
+  RIGHT,
+  CENTER
+} horizontal_alignment_t;
+
+typedef enum vertical_alignment
+{
+  TOP,
+  BOTTOM,
+  MIDDLE
+} vertical_alignment_t;
+
+struct Bounds
+{
+  int16_t x;
+  int16_t y;
+  uint16_t w;
+  uint16_t h;
+};
+
+struct WidthCacheEntry
+{
+  const uint8_t *font;
+  uint32_t hash;
+  uint16_t length;
+  uint16_t width;
+};
+
+class Renderer
+{
+private:
+  const uint8_t *defaultFont = u8g2_font_helvR14_tf;
+  // Direct-mapped on the hash of (font, string).
+  WidthCacheEntry widthCache[RENDERER_WIDTH_CACHE_SIZE] = {};
+
+  uint16_t measureString(const char *text, const uint8_t *font);
+  void drawGlyph(const Glyph &glyph, int16_t x, int16_t y, uint16_t color);
+
+public:
+  Display &display;
+  Renderer(Display &display);
+  uint16_t getStringWidth(const char *text, const uint8_t *font);
+  uint16_t getStringWidth(const String &text, const uint8_t *font);
+  uint16_t getStringWidth(const String &text);
+  uint16_t getStringHeight(const char *text, const uint8_t *font);
+  uint16_t getStringHeight(const String &text, const uint8_t *font);
+  uint16_t getStringHeight(const String &text);
+  void drawString(int16_t x, int16_t y, const char *text, const uint8_t *font, uint16_t color = GxEPD_BLACK, horizontal_alignment_t horizontal_alignment = LEFT, vertical_alignment_t vertical_alignment = TOP);
+  void drawString(int16_t x, int16_t y, const String &text, const uint8_t *font, uint16_t color = GxEPD_BLACK, horizontal_alignment_t horizontal_alignment = LEFT, vertical_alignment_t vertical_alignment = TOP);
+  void drawString(int16_t x, int16_t y, const String &text, uint16_t color = GxEPD_BLACK, horizontal_alignment_t horizontal_alignment = LEFT, vertical_alignment_t vertical_alignment = TOP);
+  void getStringBounds(Bounds &bounds, int16_t x, int16_t y, const char *text, const uint8_t *font, horizontal_alignment_t horizontal_alignment = LEFT, vertical_alignment_t vertical_alignment = TOP);
+  void getStringBounds(Bounds &bounds, int16_t x, int16_t y, const String &text, const uint8_t *font, horizontal_alignment_t horizontal_alignment = LEFT, vertical_alignment_t vertical_alignment = TOP);
+  void getStringBounds(Bounds &bounds, int16_t x, int16_t y, const String &text, horizontal_alignment_t horizontal_alignment = LEFT, vertical_alignment_t vertical_alignment = TOP);
+  void drawCheckboard(const Bounds &bounds, uint16_t squareSize = 1, uint16_t color1 = GxEPD_WHITE, uint16_t color2 = GxEPD_BLACK);
+  void drawBounds(const Bounds &bounds, uint16_t color = GxEPD_BLACK);
+  bool hasDescender(const char *text);
+  bool hasDescender(const String &text);
+  // Fills `offsets` and `widths` with the byte offset and the width of every
+  // prefix of `text` ending on a code point, the empty one first. Returns how
+  // many prefixes were measured, at most `capacity`.
+  size_t getPrefixWidths(const char *text, const uint8_t *font, uint16_t *offsets, uint16_t *widths, size_t capacity);
+  // Length in bytes of the longest prefix of `text` that fits in `width` once
+  // followed by an ellipsis, or its full length when it fits. `truncated`
+  // tells whether the ellipsis is needed.
+  size_t fitPrefix(const char *text, uint16_t width, const uint8_t *font, bool &truncated);
+  // Copies into `buffer` the longest prefix of `text` that fits in `width`
+  // once followed by an ellipsis, or `text` itself when it fits.
+  void ellipsize(const char *text, uint16_t width, const uint8_t *font, char *buffer, size_t size);
+  // Copies `length` bytes of `text` into `buffer`, followed by an ellipsis
+  // when `truncated`.
+  static void ellipsize(const char *text, size_t length, bool truncated, char *buffer, size_t size);
+};
+#endif
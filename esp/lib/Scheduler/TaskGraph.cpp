@@ -0,0 +1,66 @@
+#include "TaskGraph.h"
+
+TaskGraph::TaskGraph() : done(xEventGroupCreate()), numNodes(0) {}
+
+TaskGraph::~TaskGraph()
+{
+    // Tasks hold pointers to their node.
+    wait((1UL << numNodes) - 1);
+    vEventGroupDelete(done);
+}
+
+int TaskGraph::add(const char *name, Step step, void *arg, uint32_t dependencies, uint32_t stackSize)
+{
+    if (numNodes >= TASK_GRAPH_MAX_STEPS)
+    {
+        Serial.print("Task graph full, running ");
+        Serial.print(name);
+        Serial.println(" in place");
+        wait(dependencies);
+        step(arg);
+        return -1;
+    }
+    Node &node = nodes[numNodes];
+    node = {this, name, step, arg, dependencies, numNodes};
+    numNodes++;
+    if (xTaskCreate(runTask, name, stackSize, &node, 1, nullptr) != pdPASS)
+    {
+        Serial.print("Could not start task ");
+        Serial.print(name);
+        Serial.println(", running it in place");
+        run(node);
+    }
+    return node.id;
+}
+
+void TaskGraph::wait(uint32_t steps)
+{
+    if (steps != 0)
+    {
+        xEventGroupWaitBits(done, steps, pdFALSE, pdTRUE, portMAX_DELAY);
+    }
+}
+
+bool TaskGraph::isDone(int id)
+{
+    return (xEventGroupGetBits(done) & bit(id)) != 0;
+}
+
+void TaskGraph::run(Node &node)
+{
+    node.graph->wait(node.dependencies);
+    uint32_t startTime = millis();
+    node.step(node.arg);
+    Serial.print("Boot step ");
+    Serial.print(node.name);
+    Serial.print(" done in ");
+    Serial.print(millis() - startTime);
+    Serial.println(" ms");
+    xEventGroupSetBits(node.graph->done, bit(node.id));
+}
+
+void TaskGraph::runTask(void *node)
+{
+    run(*static_cast<Node *>(node));
+    vTaskDelete(nullptr);
+}
@@ -0,0 +1,53 @@
+#ifndef __TASK_GRAPH_H__
+#define __TASK_GRAPH_H__
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+
+#define TASK_GRAPH_MAX_STEPS 8
+#define TASK_GRAPH_STACK_SIZE 4096
+
+// Runs boot steps on their own tasks, each one as soon as the steps it
+// depends on are done, so independent phases overlap. Steps only share
+// what they are handed through `arg`.
+class TaskGraph
+{
+public:
+    typedef void (*Step)(void *arg);
+
+    TaskGraph();
+    ~TaskGraph();
+
+    // Starts `step` once every step in the `dependencies` mask is done and
+    // returns its id. Steps that cannot get a task run in place.
+    int add(const char *name, Step step, void *arg, uint32_t dependencies = 0, uint32_t stackSize = TASK_GRAPH_STACK_SIZE);
+    // Blocks until every step in the `steps` mask is done.
+    void wait(uint32_t steps);
+    bool isDone(int id);
+
+    static uint32_t bit(int id)
+    {
+        return id >= 0 ? 1UL << id : 0;
+    }
+
+private:
+    struct Node
+    {
+        TaskGraph *graph;
+        const char *name;
+        Step step;
+        void *arg;
+        uint32_t dependencies;
+        uint8_t id;
+    };
+
+    EventGroupHandle_t done;
+    Node nodes[TASK_GRAPH_MAX_STEPS];
+    uint8_t numNodes;
+
+    static void run(Node &node);
+    static void runTask(void *node);
+};
+
+#endif
@@ -0,0 +1,141 @@
+#include <WakeScheduler.h>
+
+#include <esp_attr.h>
+#include <esp_sleep.h>
+#include <sys/time.h>
+
+#define LATENCY_EMA_SHIFT 2 // new samples weigh 1/4
+#define MAX_LATENCY_SAMPLE 30000 // ms
+
+struct ScheduleState
+{
+    int64_t scheduledWakeUs; // when the wake timer was set to fire
+    int64_t deadlineUs;      // when the wake should be ready
+    uint32_t bootLatencyMs[2]; // offline, online
+    bool lastOnline;
+};
+
+RTC_DATA_ATTR static ScheduleState schedule = {};
+
+static int64_t nowUs()
+{
+    timeval tv;
+    gettimeofday(&tv, nullptr);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+uint32_t WakeScheduler::bootLatency(bool online)
+{
+    return schedule.bootLatencyMs[online] > 0 ? schedule.bootLatencyMs[online] : STARTUP_DELAY * 1000;
+}
+
+uint32_t WakeScheduler::bootLatency()
+{
+    return bootLatency(schedule.lastOnline);
+}
+
+void WakeScheduler::markReady(bool radioOn, bool wentOnline)
+{
+    int64_t readyUs = nowUs();
+    bool scheduled = schedule.scheduledWakeUs > 0 && esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER;
+    if (scheduled)
+    {
+        int64_t sampleMs = (readyUs - schedule.scheduledWakeUs) / 1000;
+        if (sampleMs >= 0 && sampleMs <= MAX_LATENCY_SAMPLE)
+        {
+            int32_t latency = bootLatency(wentOnline);
+            schedule.bootLatencyMs[wentOnline] = latency + (((int32_t)sampleMs - latency) >> LATENCY_EMA_SHIFT);
+        }
+        Serial.print("Ready ");
+        Serial.print((int32_t)sampleMs);
+        Serial.print(wentOnline ? " ms after wake, online" : " ms after wake, offline");
+        Serial.print(" boot latency estimate is ");
+        Serial.print(bootLatency(wentOnline));
+        Serial.println(" ms");
+    }
+    schedule.lastOnline = wentOnline;
+
+    int64_t waitUs = schedule.deadlineUs - readyUs;
+    schedule.scheduledWakeUs = 0;
+    if (!scheduled || waitUs <= 0 || waitUs > MAX_READY_WAIT * 1000000LL)
+    {
+        return;
+    }
+    if (radioOn)
+    {
+        Serial.print("Waiting ");
+        Serial.print((int32_t)(waitUs / 1000));
+        Serial.println(" ms until deadline");
+        delay(waitUs / 1000);
+        return;
+    }
+    Serial.print("Light sleeping ");
+    Serial.print((int32_t)(waitUs / 1000));
+    Serial.println(" ms until deadline");
+    Serial.flush();
+    esp_sleep_enable_timer_wakeup(waitUs);
+    esp_light_sleep_start();
+}
+
+time_t WakeScheduler::nextDeadline(int period)
+{
+    if (period <= 0)
+    {
+        period = 60;
+    }
+    time_t earliest = time(nullptr) + MIN_SLEEP_DURATION + bootLatency() / 1000;
+    return ((earliest + period - 1) / period) * period;
+}
+
+time_t WakeScheduler::nextDeadline(int period, time_t nextChange, const time_t *wakeTimes, size_t numWakeTimes)
+{
+    time_t now = time(nullptr);
+    time_t earliest = now + MIN_SLEEP_DURATION + bootLatency() / 1000;
+    // Past or imminent advice is stale, fall back to polling.
+    time_t deadline = nextChange >= earliest ? nextChange : nextDeadline(period);
+    for (size_t i = 0; i < numWakeTimes; i++)
+    {
+        if (wakeTimes[i] >= earliest && wakeTimes[i] < deadline)
+        {
+            deadline = wakeTimes[i];
+        }
+    }
+    if (deadline > now + MAX_SLEEP_DURATION)
+    {
+        deadline = now + MAX_SLEEP_DURATION;
+    }
+    return deadline;
+}
+
+void WakeScheduler::sleepUntil(time_t deadline)
+{
+    int64_t now = nowUs();
+    int64_t deadlineUs = (int64_t)deadline * 1000000;
+    int64_t wakeUs = deadlineUs - (int64_t)bootLatency() * 1000;
+    if (wakeUs - now < MIN_SLEEP_DURATION * 1000000LL)
+    {
+        wakeUs = now + MIN_SLEEP_DURATION * 1000000LL;
+    }
+    schedule.deadlineUs = deadlineUs;
+    schedule.scheduledWakeUs = wakeUs;
+
+    uint64_t sleepDuration = wakeUs - now;
+    esp_sleep_enable_timer_wakeup(sleepDuration);
+    Serial.print("Entering deep sleep for ");
+    Serial.print((uint32_t)(sleepDuration / 1000));
+    Serial.println(" ms");
+    Serial.end();
+    esp_deep_sleep_start();
+}
+
+void WakeScheduler::sleepFor(uint32_t seconds)
+{
+    schedule.deadlineUs = 0;
+    schedule.scheduledWakeUs = 0;
+    esp_sleep_enable_timer_wakeup((uint64_t)seconds * 1000000);
+    Serial.print("Entering deep sleep for ");
+    Serial.print(seconds);
+    Serial.println("s");
+    Serial.end();
+    esp_deep_sleep_start();
+}
@@ -0,0 +1,54 @@
+#ifndef __WAKE_SCHEDULER_H__
+#define __WAKE_SCHEDULER_H__
+
+#include <Arduino.h>
+#include <time.h>
+
+#ifndef STARTUP_DELAY
+#define STARTUP_DELAY 3 // s, initial boot-to-ready estimate
+#endif
+
+#ifndef MIN_SLEEP_DURATION
+#define MIN_SLEEP_DURATION 5 // s
+#endif
+
+#ifndef MAX_SLEEP_DURATION
+#define MAX_SLEEP_DURATION 3600 // s, bounds server-advised wakes
+#endif
+
+#ifndef MAX_READY_WAIT
+#define MAX_READY_WAIT 15 // s, longest wait for a deadline
+#endif
+
+// Schedules wakes against absolute wall-clock deadlines. The device is put
+// to sleep so that it is ready to draw exactly at the deadline, using
+// exponential moving averages of the boot-to-ready latency kept in RTC
+// memory: one for wakes that went online, one for wakes that kept the radio
+// off, which are ready much sooner.
+class WakeScheduler
+{
+public:
+    // Call right before the panel refresh. Records a latency sample when
+    // this wake was scheduled, in the estimate of wakes that went online
+    // when `wentOnline`, and waits until the deadline it was scheduled for,
+    // if that is still ahead: in light sleep, or with the modem sleeping
+    // between beacons while `radioOn`, which light sleep would disconnect.
+    static void markReady(bool radioOn, bool wentOnline);
+    static uint32_t bootLatency(bool online); // ms
+    // Estimate for the next wake, taken to go like the last one that
+    // got ready.
+    static uint32_t bootLatency(); // ms
+
+    // Next multiple of `period` seconds, at least MIN_SLEEP_DURATION from now.
+    static time_t nextDeadline(int period);
+    // Deadline honoring the server's advice: `nextChange` replaces the
+    // periodic deadline when set, and the earliest upcoming wake time is
+    // taken if sooner. The result is never further than MAX_SLEEP_DURATION.
+    static time_t nextDeadline(int period, time_t nextChange, const time_t *wakeTimes, size_t numWakeTimes);
+    // Deep sleeps so that the next wake is ready at `deadline`. The duration
+    // is computed at sleep entry, so all the work done before is accounted.
+    static void sleepUntil(time_t deadline);
+    static void sleepFor(uint32_t seconds);
+};
+
+#endif
@@ -0,0 +1,50 @@
+#include <ZoneSchedule.h>
+
+#include <esp_attr.h>
+
+struct ZoneScheduleState
+{
+    int configVersion;
+    time_t lastUpdate[ZONE_SCHEDULE_MAX_ZONES];
+};
+
+RTC_DATA_ATTR static ZoneScheduleState zoneState = {};
+
+void ZoneSchedule::begin(int configVersion)
+{
+    if (zoneState.configVersion != configVersion)
+    {
+        invalidate();
+        zoneState.configVersion = configVersion;
+    }
+}
+
+bool ZoneSchedule::isDue(uint8_t zone, int period, time_t now)
+{
+    if (zone >= ZONE_SCHEDULE_MAX_ZONES || zoneState.lastUpdate[zone] == 0)
+    {
+        return true;
+    }
+    if (period <= 0)
+    {
+        period = 60;
+    }
+    return (now + ZONE_SCHEDULE_TOLERANCE) / period > zoneState.lastUpdate[zone] / period;
+}
+
+void ZoneSchedule::markUpdated(uint8_t zone, time_t now)
+{
+    if (zone < ZONE_SCHEDULE_MAX_ZONES)
+    {
+        // Early wakes are recorded on the boundary they were meant for.
+        zoneState.lastUpdate[zone] = now + ZONE_SCHEDULE_TOLERANCE;
+    }
+}
+
+void ZoneSchedule::invalidate()
+{
+    for (uint8_t i = 0; i < ZONE_SCHEDULE_MAX_ZONES; i++)
+    {
+        zoneState.lastUpdate[i] = 0;
+    }
+}
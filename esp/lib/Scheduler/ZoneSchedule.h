@@ -0,0 +1,29 @@
+#ifndef __ZONE_SCHEDULE_H__
+#define __ZONE_SCHEDULE_H__
+
+#include <Arduino.h>
+#include <DisplayInfo.h>
+#include <time.h>
+
+// One slot per zone a display config can hold.
+#define ZONE_SCHEDULE_MAX_ZONES DISPLAY_INFO_MAX_ZONES
+
+#ifndef ZONE_SCHEDULE_TOLERANCE
+#define ZONE_SCHEDULE_TOLERANCE 5 // s, a wake this early still counts as on time
+#endif
+
+// When each zone of the display was last drawn, kept in RTC memory. A zone
+// is due once a multiple of its period has passed since, the same
+// boundaries WakeScheduler wakes on.
+class ZoneSchedule
+{
+public:
+    // Forgets every zone when the config they were drawn from changed.
+    static void begin(int configVersion);
+    static bool isDue(uint8_t zone, int period, time_t now);
+    static void markUpdated(uint8_t zone, time_t now);
+    // Makes every zone due, e.g. after the panel was cleared.
+    static void invalidate();
+};
+
+#endif
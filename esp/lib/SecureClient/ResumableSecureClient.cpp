@@ -0,0 +1,324 @@
+#include "ResumableSecureClient.h"
+
+#include <esp_crt_bundle.h>
+#include <lwip/sockets.h>
+
+#ifdef API_CA_CERT
+static const char *caCertPem = API_CA_CERT;
+#endif
+
+ResumableSecureClient::ResumableSecureClient() : tls(nullptr), port(0), isConnected(false), peeked(-1)
+{
+    host[0] = '\0';
+}
+
+ResumableSecureClient::~ResumableSecureClient()
+{
+    stop();
+}
+
+int ResumableSecureClient::connect(IPAddress ip, uint16_t port)
+{
+    return connect(ip, port, 0);
+}
+
+int ResumableSecureClient::connect(IPAddress ip, uint16_t port, int32_t timeout)
+{
+    return open(ip.toString().c_str(), nullptr, port, timeout);
+}
+
+int ResumableSecureClient::connect(const char *host, uint16_t port)
+{
+    return connect(host, port, 0);
+}
+
+int ResumableSecureClient::connect(const char *host, uint16_t port, int32_t timeout)
+{
+    // URLs may carry an IP address too.
+    IPAddress ip;
+    return open(host, ip.fromString(host) ? nullptr : host, port, timeout);
+}
+
+int ResumableSecureClient::open(const char *address, const char *serverName, uint16_t port, int32_t timeout)
+{
+    stop();
+    bool offerSession = serverName != nullptr && TlsSessionCache::has(serverName, port);
+    bool sessionRejected = false;
+    int ret = handshake(address, serverName, port, timeout, offerSession, sessionRejected);
+    if (sessionRejected)
+    {
+        Serial.println("TLS resumption rejected, retrying with a full handshake");
+        TlsSessionCache::invalidate();
+        ret = handshake(address, serverName, port, timeout, false, sessionRejected);
+    }
+    if (ret != 0)
+    {
+        Serial.print("TLS handshake failed: -0x");
+        Serial.println(-ret, HEX);
+        return 0;
+    }
+    strncpy(this->host, serverName != nullptr ? serverName : "", sizeof(this->host) - 1);
+    this->host[sizeof(this->host) - 1] = '\0';
+    this->port = port;
+    isConnected = true;
+    return 1;
+}
+
+int ResumableSecureClient::handshake(const char *address, const char *serverName, uint16_t port, int32_t timeout, bool offerSession, bool &sessionRejected)
+{
+    sessionRejected = false;
+    release();
+    tls = new TlsContext();
+    mbedtls_net_init(&tls->net);
+    mbedtls_ssl_init(&tls->ssl);
+    mbedtls_ssl_config_init(&tls->conf);
+    mbedtls_entropy_init(&tls->entropy);
+    mbedtls_ctr_drbg_init(&tls->drbg);
+    mbedtls_x509_crt_init(&tls->caCert);
+
+    uint32_t startTime = millis();
+    int ret = mbedtls_ctr_drbg_seed(&tls->drbg, mbedtls_entropy_func, &tls->entropy, nullptr, 0);
+    if (ret != 0)
+        return ret;
+
+    char portString[6];
+    snprintf(portString, sizeof(portString), "%u", port);
+    ret = mbedtls_net_connect(&tls->net, address, portString, MBEDTLS_NET_PROTO_TCP);
+    if (ret != 0)
+        return ret;
+
+    ret = mbedtls_ssl_config_defaults(&tls->conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+    if (ret != 0)
+        return ret;
+
+#ifdef API_CA_CERT
+    ret = mbedtls_x509_crt_parse(&tls->caCert, (const unsigned char *)caCertPem, strlen(caCertPem) + 1);
+    if (ret != 0)
+        return ret;
+    mbedtls_ssl_conf_ca_chain(&tls->conf, &tls->caCert, nullptr);
+#else
+    ret = esp_crt_bundle_attach(&tls->conf);
+    if (ret != 0)
+        return ret;
+#endif
+    mbedtls_ssl_conf_authmode(&tls->conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    mbedtls_ssl_conf_rng(&tls->conf, mbedtls_ctr_drbg_random, &tls->drbg);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_conf_session_tickets(&tls->conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+    mbedtls_ssl_conf_read_timeout(&tls->conf, timeout > 0 ? timeout : 5000);
+
+    ret = mbedtls_ssl_setup(&tls->ssl, &tls->conf);
+    if (ret != 0)
+        return ret;
+    // An explicit nullptr sends no SNI and skips the name check, the chain
+    // is still verified.
+    ret = mbedtls_ssl_set_hostname(&tls->ssl, serverName);
+    if (ret != 0)
+        return ret;
+    mbedtls_ssl_set_bio(&tls->ssl, &tls->net, mbedtls_net_send, nullptr, mbedtls_net_recv_timeout);
+
+    if (offerSession)
+    {
+        offerSession = TlsSessionCache::restore(serverName, port, &tls->ssl);
+    }
+
+    while ((ret = mbedtls_ssl_handshake(&tls->ssl)) != 0)
+    {
+        if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE)
+        {
+            sessionRejected = offerSession;
+            return ret;
+        }
+    }
+
+    // Reads and writes after the handshake must not block HTTPClient's polling.
+    mbedtls_net_set_nonblock(&tls->net);
+    mbedtls_ssl_set_bio(&tls->ssl, &tls->net, mbedtls_net_send, mbedtls_net_recv, nullptr);
+
+    Serial.print("TLS handshake ");
+    Serial.print(offerSession ? "(session offered) " : "");
+    Serial.print("done in ");
+    Serial.print(millis() - startTime);
+    Serial.println(" ms");
+    return 0;
+}
+
+int ResumableSecureClient::pollRecord()
+{
+    if (!isConnected)
+        return 0;
+    int ret = mbedtls_ssl_read(&tls->ssl, nullptr, 0);
+#if defined(MBEDTLS_SSL_PROTO_TLS1_3)
+    if (ret == MBEDTLS_ERR_SSL_RECEIVED_NEW_SESSION_TICKET)
+    {
+        // TLS 1.3 tickets arrive after the handshake, keep the freshest one.
+        if (host[0] != '\0')
+            TlsSessionCache::store(host, port, &tls->ssl);
+        ret = 0;
+    }
+#endif
+    if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE)
+    {
+        isConnected = false;
+    }
+    return mbedtls_ssl_get_bytes_avail(&tls->ssl);
+}
+
+size_t ResumableSecureClient::write(uint8_t data)
+{
+    return write(&data, 1);
+}
+
+size_t ResumableSecureClient::write(const uint8_t *buf, size_t size)
+{
+    if (!isConnected)
+        return 0;
+    size_t written = 0;
+    uint32_t start = millis();
+    while (written < size)
+    {
+        int ret = mbedtls_ssl_write(&tls->ssl, buf + written, size - written);
+        if (ret > 0)
+        {
+            written += ret;
+        }
+        else if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE)
+        {
+            if (millis() - start > 5000)
+                break;
+            delay(1);
+        }
+        else
+        {
+            isConnected = false;
+            break;
+        }
+    }
+    return written;
+}
+
+int ResumableSecureClient::available()
+{
+    return (peeked >= 0 ? 1 : 0) + pollRecord();
+}
+
+int ResumableSecureClient::read()
+{
+    uint8_t data;
+    return read(&data, 1) == 1 ? data : -1;
+}
+
+int ResumableSecureClient::read(uint8_t *buf, size_t size)
+{
+    if (size == 0)
+        return 0;
+    int offset = 0;
+    if (peeked >= 0)
+    {
+        buf[0] = peeked;
+        peeked = -1;
+        offset = 1;
+        if (size == 1)
+            return 1;
+    }
+    if (!isConnected)
+        return offset > 0 ? offset : -1;
+
+    int ret = mbedtls_ssl_read(&tls->ssl, buf + offset, size - offset);
+    if (ret > 0)
+        return ret + offset;
+    if (ret == 0 || (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE
+#if defined(MBEDTLS_SSL_PROTO_TLS1_3)
+                     && ret != MBEDTLS_ERR_SSL_RECEIVED_NEW_SESSION_TICKET
+#endif
+                     ))
+    {
+        isConnected = false;
+    }
+    return offset > 0 ? offset : -1;
+}
+
+int ResumableSecureClient::peek()
+{
+    if (peeked < 0)
+    {
+        uint8_t data;
+        if (read(&data, 1) == 1)
+            peeked = data;
+    }
+    return peeked;
+}
+
+void ResumableSecureClient::flush()
+{
+    // Like NetworkClient: drops what has been received and not read yet.
+    uint8_t discard[128];
+    while (available() > 0)
+    {
+        if (read(discard, sizeof(discard)) <= 0)
+            break;
+    }
+}
+
+uint8_t ResumableSecureClient::connected()
+{
+    if (peeked >= 0 || (tls != nullptr && mbedtls_ssl_get_bytes_avail(&tls->ssl) > 0))
+        return 1;
+    if (!isConnected)
+        return 0;
+
+    uint8_t dummy;
+    int ret = recv(tls->net.fd, &dummy, 1, MSG_DONTWAIT | MSG_PEEK);
+    if (ret == 0 || (ret < 0 && errno != EWOULDBLOCK && errno != EAGAIN))
+    {
+        isConnected = false;
+    }
+    return isConnected;
+}
+
+void ResumableSecureClient::stop()
+{
+    if (tls != nullptr && isConnected)
+    {
+        if (host[0] != '\0')
+            TlsSessionCache::store(host, port, &tls->ssl);
+        mbedtls_ssl_close_notify(&tls->ssl);
+    }
+    isConnected = false;
+    peeked = -1;
+    release();
+}
+
+void ResumableSecureClient::release()
+{
+    if (tls == nullptr)
+        return;
+    mbedtls_ssl_free(&tls->ssl);
+    mbedtls_ssl_config_free(&tls->conf);
+    mbedtls_ctr_drbg_free(&tls->drbg);
+    mbedtls_entropy_free(&tls->entropy);
+    mbedtls_x509_crt_free(&tls->caCert);
+    mbedtls_net_free(&tls->net);
+    delete tls;
+    tls = nullptr;
+}
+
+static const char *capabilitiesHeader = nullptr;
+static const char *capabilitiesValue = nullptr;
+
+void setRequestCapabilities(const char *header, const char *capabilities)
+{
+    capabilitiesHeader = header;
+    capabilitiesValue = capabilities;
+}
+
+bool beginRequest(HTTPClient &http, ResumableSecureClient &secureClient, const String &url)
+{
+    bool success = url.startsWith("https://") ? http.begin(secureClient, url) : http.begin(url);
+    if (success && capabilitiesHeader != nullptr)
+    {
+        http.addHeader(capabilitiesHeader, capabilitiesValue);
+    }
+    return success;
+}
@@ -0,0 +1,74 @@
+#ifndef RESUMABLE_SECURE_CLIENT_H
+#define RESUMABLE_SECURE_CLIENT_H
+
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <NetworkClient.h>
+
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/x509_crt.h>
+
+#include "TlsSessionCache.h"
+
+struct TlsContext
+{
+    mbedtls_net_context net;
+    mbedtls_ssl_context ssl;
+    mbedtls_ssl_config conf;
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context drbg;
+    mbedtls_x509_crt caCert;
+};
+
+// TLS client for HTTPClient that offers the session cached in RTC memory on
+// connect and stores the (possibly renewed) session back when the connection
+// closes. A failed handshake with the cached session falls back to a full
+// one. Servers reached by IP address get neither SNI nor session caching.
+class ResumableSecureClient : public NetworkClient
+{
+private:
+    TlsContext *tls;
+    char host[TLS_SESSION_HOST_SIZE]; // server name, empty for an IP address
+    uint16_t port;
+    bool isConnected;
+    int peeked;
+
+    // `serverName` is sent as SNI and checked against the certificate,
+    // nullptr for an IP address. `sessionRejected` is set when the
+    // handshake itself failed while a cached session was offered,
+    // connection errors leave it unset.
+    int handshake(const char *address, const char *serverName, uint16_t port, int32_t timeout, bool offerSession, bool &sessionRejected);
+    int open(const char *address, const char *serverName, uint16_t port, int32_t timeout);
+    int pollRecord();
+    void release();
+
+public:
+    ResumableSecureClient();
+    ~ResumableSecureClient();
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(IPAddress ip, uint16_t port, int32_t timeout) override;
+    int connect(const char *host, uint16_t port) override;
+    int connect(const char *host, uint16_t port, int32_t timeout) override;
+    size_t write(uint8_t data) override;
+    size_t write(const uint8_t *buf, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t *buf, size_t size) override;
+    int peek() override;
+    void flush() override;
+    void stop() override;
+    uint8_t connected() override;
+};
+
+// Binds `http` to `url`, routing https:// URLs through `secureClient`.
+// Every request carries the header set by setRequestCapabilities().
+bool beginRequest(HTTPClient &http, ResumableSecureClient &secureClient, const String &url);
+// Value of the capabilities header, e.g. deviceCapabilities(). Must outlive
+// the requests.
+void setRequestCapabilities(const char *header, const char *capabilities);
+
+#endif // RESUMABLE_SECURE_CLIENT_H
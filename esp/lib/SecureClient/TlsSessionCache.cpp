@@ -0,0 +1,79 @@
+#include "TlsSessionCache.h"
+
+#include <esp_attr.h>
+
+struct TlsSessionSlot
+{
+    char host[TLS_SESSION_HOST_SIZE];
+    uint16_t port;
+    uint16_t length;
+    uint8_t data[TLS_SESSION_MAX_SIZE];
+};
+
+RTC_DATA_ATTR static TlsSessionSlot sessionSlot = {};
+
+bool TlsSessionCache::has(const char *host, uint16_t port)
+{
+    return sessionSlot.length > 0 && sessionSlot.port == port && strncmp(sessionSlot.host, host, sizeof(sessionSlot.host)) == 0;
+}
+
+bool TlsSessionCache::restore(const char *host, uint16_t port, mbedtls_ssl_context *ssl)
+{
+    if (!has(host, port))
+    {
+        return false;
+    }
+
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    int ret = mbedtls_ssl_session_load(&session, sessionSlot.data, sessionSlot.length);
+    if (ret == 0)
+    {
+        ret = mbedtls_ssl_set_session(ssl, &session);
+    }
+    mbedtls_ssl_session_free(&session);
+
+    if (ret != 0)
+    {
+        Serial.print("Could not restore cached TLS session: -0x");
+        Serial.println(-ret, HEX);
+        invalidate();
+        return false;
+    }
+    return true;
+}
+
+bool TlsSessionCache::store(const char *host, uint16_t port, const mbedtls_ssl_context *ssl)
+{
+    if (strlen(host) >= sizeof(sessionSlot.host))
+    {
+        return false;
+    }
+
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    int ret = mbedtls_ssl_get_session(ssl, &session);
+    size_t length = 0;
+    if (ret == 0)
+    {
+        ret = mbedtls_ssl_session_save(&session, sessionSlot.data, sizeof(sessionSlot.data), &length);
+    }
+    mbedtls_ssl_session_free(&session);
+
+    if (ret != 0)
+    {
+        // Too large (e.g. a kept peer certificate) or nothing to resume.
+        invalidate();
+        return false;
+    }
+
+    strncpy(sessionSlot.host, host, sizeof(sessionSlot.host));
+    sessionSlot.port = port;
+    sessionSlot.length = length;
+    return true;
+}
+
+void TlsSessionCache::invalidate()
+{
+    sessionSlot.length = 0;
+}
@@ -0,0 +1,24 @@
+#ifndef TLS_SESSION_CACHE_H
+#define TLS_SESSION_CACHE_H
+
+#include <Arduino.h>
+#include <mbedtls/ssl.h>
+
+#ifndef TLS_SESSION_MAX_SIZE
+#define TLS_SESSION_MAX_SIZE 2048
+#endif
+
+#define TLS_SESSION_HOST_SIZE 64
+
+// Keeps the last negotiated TLS session (ticket or session id) in RTC memory
+// so the next wake can resume it instead of doing a full handshake.
+class TlsSessionCache
+{
+public:
+    static bool restore(const char *host, uint16_t port, mbedtls_ssl_context *ssl);
+    static bool store(const char *host, uint16_t port, const mbedtls_ssl_context *ssl);
+    static void invalidate();
+    static bool has(const char *host, uint16_t port);
+};
+
+#endif // TLS_SESSION_CACHE_H
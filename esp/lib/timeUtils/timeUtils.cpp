@@ -1,14 +1,149 @@
 #include <timeUtils.h>
+#include <esp_attr.h>
 #include <esp_sntp.h>
+#include <esp_timer.h>
+#include <sys/time.h>
 
 const char *TIMEZONE = "CET-1CEST,M3.5.0,M10.5.0/3"; // Europe/Zurich
 const char *NTP_SERVER_1 = "pool.ntp.org";
 const char *NTP_SERVER_2 = "time.nist.gov";
 const unsigned long NTP_TIMEOUT = 20000; // ms
 
-bool syncSNTP(tm *timeInfo)
+// Before this the RTC clock has never been set.
+#define MIN_VALID_TIME 1700000000
+#define HTTP_DATE_ERROR 1000 // ms
+
+struct TimeSyncState
+{
+    int64_t lastSyncUs;    // wall clock at the last SNTP sync
+    int64_t lastCorrectUs; // wall clock at the last drift correction
+    int32_t driftPpm;      // positive when the RTC runs fast
+    bool hasDrift;
+    bool lastSyncPrecise;  // SNTP, as opposed to an HTTP Date header
+    uint16_t syncErrorMs;  // error right after the last sync
+};
+
+RTC_DATA_ATTR static TimeSyncState syncState = {};
+
+// Wall clock and monotonic clock when the pending SNTP request was started,
+// used to tell how far off the RTC was once the answer arrives.
+static int64_t syncStartWallUs = 0;
+static int64_t syncStartMonoUs = 0;
+static bool syncPending = false;
+
+static int64_t nowUs()
+{
+    timeval tv;
+    gettimeofday(&tv, nullptr);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static void setNowUs(int64_t us)
+{
+    timeval tv = {(time_t)(us / 1000000), (suseconds_t)(us % 1000000)};
+    settimeofday(&tv, nullptr);
+}
+
+static void onTimeSync(timeval *tv)
+{
+    int64_t syncedUs = (int64_t)tv->tv_sec * 1000000 + tv->tv_usec;
+    if (syncPending && syncState.lastSyncUs > 0 && syncState.lastSyncPrecise)
+    {
+        int64_t localUs = syncStartWallUs + (esp_timer_get_time() - syncStartMonoUs);
+        int64_t elapsedUs = localUs - syncState.lastSyncUs;
+        if (elapsedUs > 60 * 1000000LL)
+        {
+            // What is left after compensation is the error in the current drift estimate.
+            int32_t residualPpm = (int32_t)((localUs - syncedUs) * 1000000 / elapsedUs);
+            syncState.driftPpm = syncState.hasDrift ? syncState.driftPpm + residualPpm : residualPpm;
+            syncState.hasDrift = true;
+            Serial.print("Clock was off by ");
+            Serial.print((int32_t)((localUs - syncedUs) / 1000));
+            Serial.print(" ms, drift is now ");
+            Serial.print(syncState.driftPpm);
+            Serial.println(" ppm");
+        }
+    }
+    syncState.lastSyncUs = syncedUs;
+    syncState.lastCorrectUs = syncedUs;
+    syncState.lastSyncPrecise = true;
+    syncState.syncErrorMs = 0;
+    syncPending = false;
+}
+
+static void startSync()
 {
+    syncStartWallUs = nowUs();
+    syncStartMonoUs = esp_timer_get_time();
+    syncPending = true;
+    sntp_set_time_sync_notification_cb(onTimeSync);
     configTzTime(TIMEZONE, NTP_SERVER_1, NTP_SERVER_2);
+}
+
+static void correctDrift()
+{
+    if (!syncState.hasDrift || syncState.lastCorrectUs == 0)
+    {
+        return;
+    }
+    int64_t now = nowUs();
+    int64_t elapsedUs = now - syncState.lastCorrectUs;
+    int64_t correctionUs = elapsedUs * syncState.driftPpm / 1000000;
+    setNowUs(now - correctionUs);
+    syncState.lastCorrectUs = now - correctionUs;
+}
+
+uint32_t estimatedTimeError()
+{
+    if (syncState.lastSyncUs == 0 || time(nullptr) < MIN_VALID_TIME)
+    {
+        return UINT32_MAX;
+    }
+    int64_t elapsedUs = nowUs() - syncState.lastSyncUs;
+    if (elapsedUs < 0)
+    {
+        return UINT32_MAX;
+    }
+    uint32_t ppm = syncState.hasDrift ? TIME_RESIDUAL_DRIFT_PPM : TIME_DEFAULT_DRIFT_PPM;
+    return syncState.syncErrorMs + (uint32_t)(elapsedUs / 1000 * ppm / 1000000);
+}
+
+bool restoreTime(tm *timeInfo)
+{
+    // The timezone lives in the environment, which does not survive deep sleep.
+    setenv("TZ", TIMEZONE, 1);
+    tzset();
+
+    if (syncState.lastSyncUs == 0 || time(nullptr) < MIN_VALID_TIME)
+    {
+        return false;
+    }
+
+    correctDrift();
+    return getCurrentTime(timeInfo);
+}
+
+bool ensureTime(tm *timeInfo)
+{
+    if (!restoreTime(timeInfo))
+    {
+        return syncSNTP(timeInfo);
+    }
+
+    uint32_t error = estimatedTimeError();
+    if (error > TIME_MAX_ERROR)
+    {
+        Serial.print("Estimated clock error is ");
+        Serial.print(error);
+        Serial.println(" ms, resyncing in the background");
+        startSync();
+    }
+    return true;
+}
+
+bool syncSNTP(tm *timeInfo)
+{
+    startSync();
     // Wait for SNTP synchronization to complete
     unsigned long timeout = millis() + NTP_TIMEOUT;
     if ((sntp_get_sync_status() == SNTP_SYNC_STATUS_RESET) && (millis() < timeout))
@@ -35,4 +170,48 @@ bool getCurrentTime(tm *timeInfo)
     }
     Serial.println(timeInfo, "%A, %B %d, %Y %H:%M:%S");
     return true;
-}
\ No newline at end of file
+}
+
+static int64_t daysFromCivil(int y, unsigned m, unsigned d)
+{
+    y -= m <= 2;
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = (unsigned)(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return (int64_t)era * 146097 + (int64_t)doe - 719468;
+}
+
+bool applyHttpDate(const char *date)
+{
+    // e.g. "Sun, 06 Nov 1994 08:49:37 GMT"
+    static const char *months = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    char month[4];
+    int day, year, hour, minute, second;
+    if (date == nullptr || sscanf(date, "%*3s, %d %3s %d %d:%d:%d", &day, month, &year, &hour, &minute, &second) != 6)
+    {
+        return false;
+    }
+    const char *found = strstr(months, month);
+    if (found == nullptr)
+    {
+        return false;
+    }
+    unsigned monthIndex = (found - months) / 3 + 1;
+
+    if (estimatedTimeError() <= 2 * HTTP_DATE_ERROR)
+    {
+        return false;
+    }
+    int64_t seconds = daysFromCivil(year, monthIndex, day) * 86400 + hour * 3600 + minute * 60 + second;
+    // The header is truncated to the second, assume the middle of it.
+    int64_t syncedUs = seconds * 1000000 + 500000;
+    setNowUs(syncedUs);
+    syncState.lastSyncUs = syncedUs;
+    syncState.lastCorrectUs = syncedUs;
+    syncState.lastSyncPrecise = false;
+    syncState.syncErrorMs = HTTP_DATE_ERROR;
+    Serial.print("Clock set from HTTP Date header: ");
+    Serial.println(date);
+    return true;
+}
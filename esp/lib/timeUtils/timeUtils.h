@@ -9,7 +9,31 @@ extern const char *NTP_SERVER_2;
 extern const char *NTP_SERVER_2;
 extern const unsigned long NTP_TIMEOUT;
 
+#ifndef TIME_MAX_ERROR
+#define TIME_MAX_ERROR 1000 // ms of estimated clock error before resyncing
+#endif
+
+#ifndef TIME_DEFAULT_DRIFT_PPM
+#define TIME_DEFAULT_DRIFT_PPM 500 // assumed RTC drift until one is measured
+#endif
+
+#ifndef TIME_RESIDUAL_DRIFT_PPM
+#define TIME_RESIDUAL_DRIFT_PPM 50 // uncertainty left once drift is compensated
+#endif
+
 bool syncSNTP(tm *timeInfo);
 bool getCurrentTime(tm *timeInfo);
 
-#endif
\ No newline at end of file
+// Trusts the RTC clock, compensated by the measured drift, and only waits
+// for SNTP when the clock was never set. When the estimated error exceeds
+// TIME_MAX_ERROR an SNTP sync is started in the background (WiFi must be up).
+bool ensureTime(tm *timeInfo);
+// Same without any network: the drift-compensated RTC clock, or false when
+// it was never set.
+bool restoreTime(tm *timeInfo);
+uint32_t estimatedTimeError(); // ms
+// Rough fallback from an HTTP Date header (1 s resolution), applied only
+// when the clock is known to be off by more than that.
+bool applyHttpDate(const char *date);
+
+#endif
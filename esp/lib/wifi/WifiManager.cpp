@@ -2,33 +2,192 @@
 
 #include <FS.h>
 #include <WiFi.h>
+#include <esp_attr.h>
+#include <esp_netif.h>
+#include <esp_netif_net_stack.h>
+#include <lwip/dhcp.h>
+#include <time.h>
+#include <timeUtils.h>
 
-void connectToWiFi(const char* ssid, const char* password, int connectTimeout)
+struct WifiCache
 {
-    WiFi.persistent(true);
-    WiFi.mode(WIFI_STA); // switch off AP
-    WiFi.setAutoReconnect(true);
+    bool valid;
+    uint8_t bssid[6];
+    int32_t channel;
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns1;
+    uint32_t dns2;
+    time_t leaseObtainedAt; // 0 until the clock is set
+    uint32_t leaseDuration; // s
+};
+
+RTC_DATA_ATTR static WifiCache wifiCache = {};
+// When the lease waiting for a clock was obtained.
+static uint32_t leaseObtainedMillis = 0;
+
+static bool waitForConnection(uint32_t timeoutMs)
+{
+    uint32_t start = millis();
+    while (WiFi.status() != WL_CONNECTED)
+    {
+        if (millis() - start > timeoutMs)
+        {
+            return false;
+        }
+        delay(WIFI_POLL_INTERVAL);
+    }
+    return true;
+}
+
+static bool isLeaseValid()
+{
+    if (!wifiCache.valid)
+    {
+        return false;
+    }
+    if (wifiCache.leaseObtainedAt == 0)
+    {
+        return false;
+    }
+    // Renewed at half the lease, as DHCP clients do.
+    time_t now = time(nullptr);
+    return now >= wifiCache.leaseObtainedAt && now - wifiCache.leaseObtainedAt < wifiCache.leaseDuration / 2;
+}
+
+// Lease the DHCP server granted on the station interface, 0 when unknown.
+static uint32_t dhcpLeaseDuration()
+{
+    esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+    struct netif *lwipNetif = netif != nullptr ? static_cast<struct netif *>(esp_netif_get_netif_impl(netif)) : nullptr;
+    struct dhcp *dhcp = lwipNetif != nullptr ? netif_dhcp_data(lwipNetif) : nullptr;
+    return dhcp != nullptr ? dhcp->offered_t0_lease : 0;
+}
+
+void stampWiFiLease()
+{
+    if (!wifiCache.valid || wifiCache.leaseObtainedAt != 0 || estimatedTimeError() == UINT32_MAX)
+    {
+        return;
+    }
+    wifiCache.leaseObtainedAt = time(nullptr) - (millis() - leaseObtainedMillis) / 1000;
+}
+
+static void storeConnection()
+{
+    memcpy(wifiCache.bssid, WiFi.BSSID(), sizeof(wifiCache.bssid));
+    wifiCache.channel = WiFi.channel();
+    // A static configuration is reused as is, only a DHCP lease restarts the clock.
+    bool newLease = !wifiCache.valid || wifiCache.ip != static_cast<uint32_t>(WiFi.localIP());
+    wifiCache.ip = WiFi.localIP();
+    wifiCache.gateway = WiFi.gatewayIP();
+    wifiCache.subnet = WiFi.subnetMask();
+    wifiCache.dns1 = WiFi.dnsIP(0);
+    wifiCache.dns2 = WiFi.dnsIP(1);
+    wifiCache.valid = true;
+    if (newLease)
+    {
+        uint32_t duration = dhcpLeaseDuration();
+        wifiCache.leaseDuration = duration > 0 ? duration : WIFI_LEASE_DURATION;
+        wifiCache.leaseObtainedAt = 0;
+        leaseObtainedMillis = millis();
+        stampWiFiLease();
+    }
+}
+
+static void beginFastConnect(const char *ssid, const char *password)
+{
+    Serial.print("Fast connecting to ");
+    Serial.print(ssid);
+    Serial.print(" on channel ");
+    Serial.println(wifiCache.channel);
+    WiFi.config(IPAddress(wifiCache.ip), IPAddress(wifiCache.gateway), IPAddress(wifiCache.subnet), IPAddress(wifiCache.dns1), IPAddress(wifiCache.dns2));
+    WiFi.begin(ssid, password, wifiCache.channel, wifiCache.bssid, true);
+}
+
+// Association started by beginWiFi() and not waited for yet.
+static const char *pendingSsid = nullptr;
+static const char *pendingPassword = nullptr;
+static uint32_t connectStartTime = 0;
+static bool connectingFast = false;
+
+static void beginFullConnect(const char *ssid, const char *password)
+{
+    wifiCache.valid = false;
     WiFi.disconnect();
     Serial.print("Connecting to ");
     Serial.println(ssid);
     WiFi.begin(ssid, password);
+}
 
-    while (WiFi.status() != WL_CONNECTED)
+static void logConnected()
+{
+    Serial.print("Connected to the WiFi network in ");
+    Serial.print(millis() - connectStartTime);
+    Serial.println(" ms");
+    Serial.println(WiFi.localIP());
+}
+
+void beginWiFi(const char* ssid, const char* password)
+{
+    connectStartTime = millis();
+    pendingSsid = ssid;
+    pendingPassword = password;
+    WiFi.persistent(true);
+    WiFi.mode(WIFI_STA); // switch off AP
+    WiFi.setAutoReconnect(true);
+
+    connectingFast = isLeaseValid();
+    if (connectingFast)
+    {
+        beginFastConnect(ssid, password);
+    }
+    else
+    {
+        beginFullConnect(ssid, password);
+    }
+}
+
+bool waitForWiFi(int connectTimeout)
+{
+    if (pendingSsid == nullptr)
     {
-        delay(500);
-        Serial.print(".");
-        Serial.print(WiFi.status());
-        if (--connectTimeout <= 0)
+        return WiFi.status() == WL_CONNECTED;
+    }
+    if (connectingFast)
+    {
+        uint32_t elapsed = millis() - connectStartTime;
+        if (waitForConnection(elapsed < WIFI_FAST_CONNECT_TIMEOUT ? WIFI_FAST_CONNECT_TIMEOUT - elapsed : 0))
         {
-            Serial.println();
-            Serial.println("WiFi connect timeout");
-            return;
+            storeConnection();
+            logConnected();
+            pendingSsid = nullptr;
+            return true;
         }
+        Serial.println("Fast connect failed, falling back to scan and DHCP");
+        // Back to DHCP
+        WiFi.config(IPAddress(), IPAddress(), IPAddress());
+        connectingFast = false;
+        beginFullConnect(pendingSsid, pendingPassword);
+    }
+    pendingSsid = nullptr;
+
+    if (!waitForConnection(connectTimeout * 500))
+    {
+        Serial.println("WiFi connect timeout");
+        return false;
     }
 
-    Serial.println("Connected to the WiFi network");
+    storeConnection();
+    logConnected();
+    return true;
+}
 
-    Serial.println(WiFi.localIP());
+bool connectToWiFi(const char* ssid, const char* password, int connectTimeout)
+{
+    beginWiFi(ssid, password);
+    return waitForWiFi(connectTimeout);
 }
 
 void disconnect()
@@ -4,7 +4,28 @@
 
 #define BUFFER_SIZE 4096
 
-void connectToWiFi(const char* ssid, const char* password, int connectTimeout = 60);
+#ifndef WIFI_FAST_CONNECT_TIMEOUT
+#define WIFI_FAST_CONNECT_TIMEOUT 3000 // ms
+#endif
+
+#ifndef WIFI_LEASE_DURATION
+#define WIFI_LEASE_DURATION 3600 // s, assumed when the DHCP server's is unknown
+#endif
+
+#define WIFI_POLL_INTERVAL 10 // ms
+
+// Connects using the BSSID, channel and DHCP lease cached in RTC memory by
+// the previous wake when possible, otherwise with a full scan and DHCP.
+// connectTimeout is expressed in 500 ms steps.
+bool connectToWiFi(const char* ssid, const char* password, int connectTimeout = 60);
+// connectToWiFi() in two halves: beginWiFi() starts associating and returns
+// at once, waitForWiFi() blocks until connected. Work that does not need
+// the network can run in between.
+void beginWiFi(const char* ssid, const char* password);
+bool waitForWiFi(int connectTimeout = 60);
+// Dates the DHCP lease obtained before the clock was set. Call once it is,
+// until then the cached lease is not reused.
+void stampWiFiLease();
 void disconnect();
 
 #endif // __WIFI_H__
@@ -5,43 +5,65 @@
 
 #include <WifiManager.h>
 #include <timeUtils.h>
+#include <WakeScheduler.h>
 #include <Display.h>
 #include <TimetableRenderer.h>
 #include <Renderer.h>
 #include <BitmapDrawer.h>
+#include <DeviceCapabilities.h>
 #include <BufferedHTTPClientReader.h>
+#include <FileSystemReader.h>
+#include <MemoryReader.h>
 #include <DisplayApiClient.h>
 #include <DisplayInfo.h>
+#include <FrameCache.h>
+#include <ZoneSchedule.h>
+#include <TaskGraph.h>
+#ifdef ENABLE_LOCAL_TIMETABLE
+#include <DeparturesDataset.h>
+#endif
 
 #ifndef LED_BUILTIN
 #define LED_BUILTIN 2
 #endif
 
-#ifndef STARTUP_DELAY
-#define STARTUP_DELAY 3
-#endif
-
 #define STORAGE_NAMESPACE "display"
 #define COUNTER_KEY "runs"
 
+#ifndef PLAYLIST_LENGTH
+#define PLAYLIST_LENGTH 3
+#endif
+
+#define TIMETABLE_MARGIN 10 // px around the local timetable
+
 Preferences preferences;
 
+RTC_DATA_ATTR char displayedEtag[FRAME_ETAG_SIZE] = "";
+
 DisplayApiClient displayApiClient(API_BASE_URL);
 
 void sendUpdate(const std::string& message, UpdateStatus status) {
-    UpdateInfo updateInfo(message, status);
-    if (displayApiClient.createDisplayUpdate(DISPLAY_ID, updateInfo)) {
-        Serial.println("Update created successfully");
+    UpdateQueue::push(UpdateInfo(message, status), time(nullptr));
+}
+
+void flushUpdates() {
+    size_t numUpdates = UpdateQueue::size();
+    if (displayApiClient.flushUpdates(DISPLAY_ID, time(nullptr))) {
+        Serial.print(numUpdates);
+        Serial.println(" updates sent successfully");
     } else {
-        Serial.println("Failed to create update");
+        Serial.print("Failed to send updates, ");
+        Serial.print(UpdateQueue::size());
+        Serial.println(" kept for next wake");
     }
 }
 
 void initializeDisplay(Display* display) {
     Serial.println("Initializing display.");
     display->initDisplay();
-    display->display.setRotation(0);
     Serial.println("Display infos");
+    Serial.print("Display rotation: ");
+    Serial.println(display->rotation);
     Serial.print("Display height: ");
     Serial.println(display->display.height());
     Serial.print("Display width: ");
@@ -50,33 +72,107 @@ void initializeDisplay(Display* display) {
     Serial.println(display->display.pageHeight());
 }
 
-void drawImages(Display* display, const DisplayInfo& displayInfo) {
+// Reads the frame from RAM when it was buffered, from the flash cache when
+// it was prefetched, from the server otherwise.
+void drawFrame(Display* display, const FrameInfo& frame, MemoryReader& buffered) {
+    SourceRect crop;
+    crop.x = frame.cropX;
+    crop.y = frame.cropY;
+    crop.width = frame.cropWidth;
+    crop.height = frame.cropHeight;
+    if (buffered.isLoaded()) {
+        BitmapDrawer drawer(buffered, *display);
+        drawer.draw(frame.format, crop, frame.x, frame.y);
+        return;
+    }
+    char path[FRAME_CACHE_PATH_SIZE];
+    if (FrameCache::find(frame.etag, path, sizeof(path))) {
+        FileSystemReader reader(LittleFS, path);
+        BitmapDrawer drawer(reader, *display);
+        drawer.draw(frame.format, crop, frame.x, frame.y);
+        return;
+    }
+    BufferedHTTPClientReader reader(displayApiClient.httpClient(), displayApiClient.secureClient(), frame.url, 2048, 10 * 1000);
+    BitmapDrawer drawer(reader, *display);
+    drawer.draw(frame.format, crop, frame.x, frame.y);
+}
+
+// Downloads the frame into `buffered` unless it is in the flash cache. False
+// when it is not and does not fit in RAM.
+bool bufferFrame(const FrameInfo& frame, MemoryReader& buffered) {
+    char path[FRAME_CACHE_PATH_SIZE];
+    if (FrameCache::find(frame.etag, path, sizeof(path))) {
+        return true;
+    }
+    if (frame.size > 0 && !MemoryReader::fits(frame.size)) {
+        return false;
+    }
+    BufferedHTTPClientReader reader(displayApiClient.httpClient(), displayApiClient.secureClient(), frame.url, 2048, 10 * 1000);
+    return buffered.load(reader, reader.getSize());
+}
+
+// Buffers both frames, or none of them: when one does not fit they are
+// streamed while drawing.
+bool bufferFrames(const WakeManifest& manifest, MemoryReader& previous, MemoryReader& current) {
+    uint32_t startTime = millis();
+    bool success = false;
+    try
+    {
+        success = (!manifest.previous.isSet() || bufferFrame(manifest.previous, previous))
+                  && bufferFrame(manifest.current, current);
+    }
+    catch (const std::exception &ex)
+    {
+        Serial.print("Could not buffer frames: ");
+        Serial.println(ex.what());
+    }
+    if (!success) {
+        previous.release();
+        current.release();
+        Serial.println("Frames do not fit in RAM, streaming them.");
+        return false;
+    }
+    Serial.print("Frames buffered in ");
+    Serial.print(millis() - startTime);
+    Serial.println(" ms");
+    return true;
+}
+
+bool drawImages(Display* display, const WakeManifest& manifest, MemoryReader& previousFrame, MemoryReader& currentFrame) {
     uint32_t startTime = millis();
 
 #ifdef ENABLE_FAST_PARTIAL_MODE
     display->display.epd2.enableFastPartialMode();
 #endif
 
-    display->display.setPartialWindow(0, 0, 800, 480);
+    // A cropped frame is a patch, only its pixels are refreshed.
+    const FrameInfo& current = manifest.current;
+    if (current.isCropped()) {
+        display->setPartialWindow(current.x, current.y, current.cropWidth, current.cropHeight);
+    } else {
+        display->setPartialWindow(0, 0, display->width(), display->height());
+    }
+    bool success = false;
     try
     {
-        if (!displayInfo.previousUrl.empty()) {
+        if (manifest.previous.isSet()) {
             Serial.println("Drawing previous image");
-            BufferedHTTPClientReader readerPrevious(displayInfo.previousUrl.c_str(), 2048, 10 * 1000);
-            BitmapDrawer drawerPrevious(readerPrevious, *display);
-            drawerPrevious.drawBitmap(10, 10);
+            display->firstPage();
+            drawFrame(display, manifest.previous, previousFrame);
         }
 
         Serial.println("Drawing current image");
-        BufferedHTTPClientReader reader(displayInfo.url.c_str(), 2048, 10 * 1000);
-        BitmapDrawer drawer(reader, *display);
-        drawer.drawBitmap(10, 10);
+        display->firstPage();
+        // The rest of the wake overlaps the refresh, setup() joins it.
+        display->refreshAsync();
+        drawFrame(display, manifest.current, currentFrame);
 
         Serial.print("Image displayed in ");
         Serial.print(millis() - startTime);
         Serial.println(" ms");
 
         sendUpdate("Images displayed successfully", UpdateStatus::PASS);
+        success = true;
     }
     catch (const std::runtime_error &re)
     {
@@ -98,24 +194,418 @@ void drawImages(Display* display, const DisplayInfo& displayInfo) {
 
         sendUpdate("Unknown error", UpdateStatus::ERROR);
     }
+    if (!success) {
+        // The page loop was left before its last page.
+        display->cancelRefreshAsync();
+    }
+
+#ifdef ENABLE_FAST_PARTIAL_MODE
+    display->waitForRefresh();
+    display->display.epd2.disableFastPartialMode();
+#endif
+    return success;
+}
+
+#ifdef ENABLE_LOCAL_TIMETABLE
+// Kept off the stack of the Arduino task.
+static Timetable timetable;
+static Timetable previousTimetable;
+
+// The whole panel, inside the margin.
+Bounds timetableBounds(Display* display) {
+    return {TIMETABLE_MARGIN, TIMETABLE_MARGIN,
+            static_cast<uint16_t>(display->width() - 2 * TIMETABLE_MARGIN),
+            static_cast<uint16_t>(display->height() - 2 * TIMETABLE_MARGIN)};
+}
+
+bool renderTimetable(Display* display, TimetableRenderer& timetableRenderer) {
+    const Bounds bounds = timetableBounds(display);
+    bool success = true;
+    display->firstPage();
+    do {
+        display->fillScreen(GxEPD_WHITE);
+        success = timetableRenderer.drawTimetable(bounds.x, bounds.y, bounds.w, bounds.h) && success;
+    } while (display->nextPage());
+    return success;
+}
+
+// Renders the timetable from the synced departures dataset instead of
+// downloading a server rendered bitmap.
+bool drawLocalTimetable(Display* display, time_t now) {
+    uint32_t startTime = millis();
+    Renderer renderer(*display);
+    TimetableRenderer timetableRenderer(renderer, timetable);
+    bool success = DeparturesDataset::load(timetable, now);
 
 #ifdef ENABLE_FAST_PARTIAL_MODE
+    display->display.epd2.enableFastPartialMode();
+
+    // Same role as the previous image in drawImages(): what the panel shows.
+    // lastRendered() is reset when a sync replaces the dataset, the panel
+    // then shows cells this dataset cannot rebuild.
+    TimetableRenderer previousRenderer(renderer, previousTimetable);
+    Bounds window;
+    int numWindows = -1;
+    time_t previous = DeparturesDataset::lastRendered();
+    bool hasPrevious = success && previous > 0 && DeparturesDataset::load(previousTimetable, previous);
+    if (hasPrevious) {
+        // Every page loop ends in a waveform, so the changed cells are
+        // refreshed together through their bounding box.
+        const Bounds bounds = timetableBounds(display);
+        numWindows = timetableRenderer.diff(previousTimetable, bounds.x, bounds.y, bounds.w, bounds.h, &window, 1);
+    }
+    if (numWindows == 0) {
+        Serial.println("Timetable unchanged");
+    } else if (numWindows > 0) {
+        Serial.print("Timetable changed in ");
+        Serial.print(window.w);
+        Serial.print("x");
+        Serial.print(window.h);
+        Serial.println(" px");
+        display->setPartialWindow(window.x, window.y, window.w, window.h);
+        renderTimetable(display, previousRenderer);
+        success = renderTimetable(display, timetableRenderer);
+    } else {
+        display->setPartialWindow(0, 0, display->width(), display->height());
+        if (hasPrevious) {
+            renderTimetable(display, previousRenderer);
+        }
+        success = success && renderTimetable(display, timetableRenderer);
+    }
+
     display->display.epd2.disableFastPartialMode();
+#else
+    display->setPartialWindow(0, 0, display->width(), display->height());
+    success = success && renderTimetable(display, timetableRenderer);
+#endif
+
+    if (success) {
+        DeparturesDataset::markRendered(now);
+        Serial.print("Timetable rendered in ");
+        Serial.print(millis() - startTime);
+        Serial.println(" ms");
+        sendUpdate("Timetable rendered locally", UpdateStatus::PASS);
+    } else {
+        sendUpdate("Could not render timetable locally", UpdateStatus::ERROR);
+    }
+    return success;
+}
+#endif
+
+// True when one of the zones due at `now` needs the server.
+bool zoneNeedsNetwork(const DisplayZone& zone, time_t now) {
+    if (zone.hasUrl()) {
+        return true;
+    }
+#ifdef ENABLE_LOCAL_TIMETABLE
+    if (strcmp(zone.renderer, "timetable") == 0 && !DeparturesDataset::isFresh(now)) {
+        return true;
+    }
+#endif
+    return false;
+}
+
+bool zonesNeedNetwork(const DisplayInfo& displayInfo, time_t now) {
+    for (uint8_t i = 0; i < displayInfo.numZones; i++) {
+        const DisplayZone& zone = displayInfo.zones[i];
+        if (ZoneSchedule::isDue(i, zone.refreshFrequency, now) && zoneNeedsNetwork(zone, now)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool zonesDue(const DisplayInfo& displayInfo, time_t now) {
+    for (uint8_t i = 0; i < displayInfo.numZones; i++) {
+        if (ZoneSchedule::isDue(i, displayInfo.zones[i].refreshFrequency, now)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Draws the time centered in `bounds`, on the current page.
+void drawClock(Renderer& renderer, const Bounds& bounds, time_t now) {
+    tm timeInfo;
+    char text[6];
+    localtime_r(&now, &timeInfo);
+    strftime(text, sizeof(text), "%H:%M", &timeInfo);
+    renderer.drawString(bounds.x + bounds.w / 2, bounds.y + bounds.h / 2, text, u8g2_font_helvB24_tf, GxEPD_BLACK, CENTER, MIDDLE);
+}
+
+bool isKnownRenderer(const char* name) {
+#ifdef ENABLE_LOCAL_TIMETABLE
+    if (strcmp(name, "timetable") == 0) {
+        return true;
+    }
+#endif
+    return strcmp(name, "clock") == 0;
+}
+
+bool intersects(const Bounds& a, const DisplayZone& zone) {
+    return a.x < zone.x + zone.width && zone.x < a.x + a.w && a.y < zone.y + zone.height && zone.y < a.y + a.h;
+}
+
+void extend(Bounds& bounds, const DisplayZone& zone) {
+    int16_t right = max<int16_t>(bounds.x + bounds.w, zone.x + zone.width);
+    int16_t bottom = max<int16_t>(bounds.y + bounds.h, zone.y + zone.height);
+    bounds.x = min<int16_t>(bounds.x, zone.x);
+    bounds.y = min<int16_t>(bounds.y, zone.y);
+    bounds.w = right - bounds.x;
+    bounds.h = bottom - bounds.y;
+}
+
+// Downloads the bitmap of a zone to draw it in the shared page loop. False
+// when it does not fit in RAM or the download failed.
+bool bufferZone(const DisplayZone& zone, MemoryReader& buffered) {
+    try {
+        BufferedHTTPClientReader reader(displayApiClient.httpClient(), displayApiClient.secureClient(), zone.url, 2048, 10 * 1000);
+        return reader.getSize() > 0 && MemoryReader::fits(reader.getSize()) && buffered.load(reader, reader.getSize());
+    } catch (const std::exception &ex) {
+        Serial.print("Could not buffer zone: ");
+        Serial.println(ex.what());
+        return false;
+    }
+}
+
+// Draws the part of a zone under the current page.
+bool drawZonePage(Display* display, Renderer& renderer, const DisplayZone& zone, MemoryReader& frame, time_t now) {
+    const Bounds bounds = {(int16_t)zone.x, (int16_t)zone.y, zone.width, zone.height};
+    if (zone.hasUrl()) {
+        try {
+            BitmapDrawer drawer(frame, *display);
+            SourceRect crop;
+            crop.width = zone.width;
+            crop.height = zone.height;
+            drawer.drawPage(nullptr, crop, zone.x, zone.y);
+            return true;
+        } catch (const std::exception &ex) {
+            Serial.print("Could not draw zone: ");
+            Serial.println(ex.what());
+            return false;
+        }
+    }
+#ifdef ENABLE_LOCAL_TIMETABLE
+    if (strcmp(zone.renderer, "timetable") == 0) {
+        TimetableRenderer timetableRenderer(renderer, timetable);
+        return timetableRenderer.drawTimetable(bounds.x, bounds.y, bounds.w, bounds.h);
+    }
 #endif
+    drawClock(renderer, bounds, now);
+    return true;
+}
+
+// Streams the bitmap of a zone that could not be buffered, in its own
+// partial window.
+bool streamZone(Display* display, const DisplayZone& zone) {
+    try {
+        BufferedHTTPClientReader reader(displayApiClient.httpClient(), displayApiClient.secureClient(), zone.url, 2048, 10 * 1000);
+        BitmapDrawer drawer(reader, *display);
+        SourceRect crop;
+        crop.width = zone.width;
+        crop.height = zone.height;
+        display->setPartialWindow(zone.x, zone.y, zone.width, zone.height);
+        display->firstPage();
+        drawer.draw(nullptr, crop, zone.x, zone.y);
+        return true;
+    } catch (const std::exception &ex) {
+        Serial.print("Could not draw zone: ");
+        Serial.println(ex.what());
+        return false;
+    }
+}
+
+// Draws the zones that are due in one partial window covering all of them,
+// so the panel refreshes once. The window is cleared first, zones it
+// overlaps are redrawn with them. Bitmaps that do not fit in RAM are
+// streamed in their own window afterwards.
+// Offline, zones that need WiFi stay due for the next wake.
+bool drawZones(Display* display, const DisplayInfo& displayInfo, time_t now, bool online) {
+    uint32_t startTime = millis();
+    bool success = true;
+    bool selected[DISPLAY_INFO_MAX_ZONES] = {};
+    bool streamed[DISPLAY_INFO_MAX_ZONES] = {};
+    bool drawn[DISPLAY_INFO_MAX_ZONES] = {};
+    Bounds window = {};
+    bool hasWindow = false;
+    for (uint8_t i = 0; i < displayInfo.numZones; i++) {
+        const DisplayZone& zone = displayInfo.zones[i];
+        if (!ZoneSchedule::isDue(i, zone.refreshFrequency, now)) {
+            continue;
+        }
+        if (!online && zoneNeedsNetwork(zone, now)) {
+            success = false;
+            continue;
+        }
+        selected[i] = true;
+        if (hasWindow) {
+            extend(window, zone);
+        } else {
+            window = {(int16_t)zone.x, (int16_t)zone.y, zone.width, zone.height};
+            hasWindow = true;
+        }
+    }
+    for (bool grown = hasWindow; grown;) {
+        grown = false;
+        for (uint8_t i = 0; i < displayInfo.numZones; i++) {
+            if (!selected[i] && intersects(window, displayInfo.zones[i])) {
+                selected[i] = true;
+                extend(window, displayInfo.zones[i]);
+                grown = true;
+            }
+        }
+    }
+    if (!online) {
+        // The window would blank a zone that cannot be redrawn.
+        for (uint8_t i = 0; i < displayInfo.numZones && hasWindow; i++) {
+            if (selected[i] && zoneNeedsNetwork(displayInfo.zones[i], now)) {
+                Serial.println("Due zones overlap one that needs WiFi, leaving them for the next wake.");
+                memset(selected, 0, sizeof(selected));
+                hasWindow = false;
+                success = false;
+            }
+        }
+    }
+
+    MemoryReader frames[DISPLAY_INFO_MAX_ZONES];
+    for (uint8_t i = 0; i < displayInfo.numZones; i++) {
+        const DisplayZone& zone = displayInfo.zones[i];
+        if (!selected[i]) {
+            continue;
+        }
+        if (zone.hasUrl()) {
+            streamed[i] = !bufferZone(zone, frames[i]);
+            selected[i] = !streamed[i];
+        } else if (!isKnownRenderer(zone.renderer)) {
+            Serial.print("Unknown zone renderer: ");
+            Serial.println(zone.renderer);
+            selected[i] = false;
+            success = false;
+        }
+#ifdef ENABLE_LOCAL_TIMETABLE
+        else if (strcmp(zone.renderer, "timetable") == 0 && !DeparturesDataset::load(timetable, now)) {
+            selected[i] = false;
+            success = false;
+        }
+#endif
+    }
+
+    if (hasWindow) {
+        Renderer renderer(*display);
+        bool failed[DISPLAY_INFO_MAX_ZONES] = {};
+        display->setPartialWindow(window.x, window.y, window.w, window.h);
+        display->firstPage();
+        do {
+            display->fillScreen(GxEPD_WHITE);
+            for (uint8_t i = 0; i < displayInfo.numZones; i++) {
+                if (selected[i] && !failed[i]) {
+                    failed[i] = !drawZonePage(display, renderer, displayInfo.zones[i], frames[i], now);
+                }
+            }
+        } while (display->nextPage());
+        for (uint8_t i = 0; i < displayInfo.numZones; i++) {
+            drawn[i] = selected[i] && !failed[i];
+            success = success && !failed[i];
+        }
+    }
+    for (uint8_t i = 0; i < displayInfo.numZones; i++) {
+        if (streamed[i]) {
+            drawn[i] = streamZone(display, displayInfo.zones[i]);
+            success = success && drawn[i];
+        }
+    }
+
+    uint8_t numDrawn = 0;
+    for (uint8_t i = 0; i < displayInfo.numZones; i++) {
+        if (drawn[i]) {
+            ZoneSchedule::markUpdated(i, now);
+            numDrawn++;
+        }
+    }
+    Serial.print(numDrawn);
+    Serial.print(" zones drawn in ");
+    Serial.print(millis() - startTime);
+    Serial.println(" ms");
+    if (success) {
+        sendUpdate("Zones displayed successfully", UpdateStatus::PASS);
+    } else {
+        sendUpdate("Could not draw every zone", UpdateStatus::ERROR);
+    }
+    return success;
+}
+
+// Builds the manifest of an offline wake from the playlist frame due now.
+// False on a cache miss, in which case the frame has to be fetched.
+bool loadCachedManifest(WakeManifest& manifest, time_t now) {
+    DisplayInfo displayInfo;
+    FrameInfo frame;
+    if (!DisplayInfoCache::load(DISPLAY_ID, displayInfo)
+        || !PlaylistCache::frameAt(DISPLAY_ID, now, frame, displayInfo.nextChange)
+        || !FrameCache::contains(frame.etag)) {
+        return false;
+    }
+    displayInfo.numWakeTimes = 0;
+    manifest.display = displayInfo;
+    manifest.previous = FrameInfo();
+    manifest.current = frame;
+    return true;
+}
+
+// Downloads the upcoming frames in one radio session so the next wakes can
+// leave WiFi off.
+bool prefetchPlaylist(WakeManifest& manifest) {
+    Playlist* playlist = new Playlist();
+    bool success = displayApiClient.getPlaylist(DISPLAY_ID, PLAYLIST_LENGTH, *playlist);
+    if (success) {
+        DisplayInfoCache::store(playlist->display, time(nullptr));
+        uint8_t numCached = 0;
+        for (uint8_t i = 0; i < playlist->numFrames; i++) {
+            if (FrameCache::fetch(displayApiClient.httpClient(), displayApiClient.secureClient(), playlist->frames[i])) {
+                numCached++;
+            }
+        }
+        Serial.print("Prefetched ");
+        Serial.print(numCached);
+        Serial.print(" of ");
+        Serial.print(playlist->numFrames);
+        Serial.println(" playlist frames");
+        PlaylistCache::store(DISPLAY_ID, *playlist);
+        success = loadCachedManifest(manifest, time(nullptr));
+    }
+    delete playlist;
+    return success;
+}
+
+// Boot steps, run by the TaskGraph in setup() next to the WiFi association.
+void loadRunCount(void* arg) {
+    unsigned int* numRuns = static_cast<unsigned int*>(arg);
+    preferences.begin(STORAGE_NAMESPACE, false);
+    *numRuns = preferences.getUInt(COUNTER_KEY, 0);
+    Serial.print("Current number of runs is ");
+    Serial.println(*numRuns);
 }
 
-uint64_t calculateSleepDuration(tm *timeInfo, int refreshFrequency) {
-    return refreshFrequency - (timeInfo->tm_sec + STARTUP_DELAY);
+void preparePanel(void* arg) {
+    Display** display = static_cast<Display**>(arg);
+    *display = new Display();
+    initializeDisplay(*display);
 }
 
-void enterDeepSleep(tm *timeInfo, int refreshFrequency) {
-    uint64_t sleepDuration = calculateSleepDuration(timeInfo, refreshFrequency);
-    esp_sleep_enable_timer_wakeup(sleepDuration * 1000000); // convert seconds to microseconds
-    Serial.print("Entering deep sleep for ");
-    Serial.print(sleepDuration);
-    Serial.println("s");
-    Serial.end();
-    esp_deep_sleep_start();
+// Brings the panel up on its own task, once. Only called when a draw is
+// known to be needed, wakes that skip the draw never power it.
+void startPanel(TaskGraph& boot, int& panelStep, Display** display) {
+    if (panelStep < 0) {
+        panelStep = boot.add("panel", preparePanel, display);
+    }
+}
+
+void joinWiFi(void* arg) {
+    waitForWiFi();
+}
+
+void syncClock(void* arg) {
+    ensureTime(static_cast<tm*>(arg));
+    stampWiFiLease();
 }
 
 void setup()
@@ -124,60 +614,217 @@ void setup()
 
     Serial.begin(115200);
     Serial.println();
-    delay(100);
-    preferences.begin(STORAGE_NAMESPACE, false);
-    unsigned int numRuns = preferences.getUInt(COUNTER_KEY, 0);
-    Serial.print("Current number of runs is ");
-    Serial.println(numRuns);
 
     Serial.println("Starting app");
-
-
-    connectToWiFi(WIFI_SSID, WIFI_PASSWORD);
+    setRequestCapabilities(DEVICE_CAPABILITIES_HEADER, deviceCapabilities());
 
     tm timeInfo = {};
-    syncSNTP(&timeInfo);
-    if (timeInfo.tm_sec >= 60 - STARTUP_DELAY)
+    WakeManifest manifest;
+    Display *display = nullptr;
+    unsigned int numRuns = 0;
+    bool hasConfig = false;
+    bool online = true;
+    bool wentOnline = false; // WiFi was started, even if it is off again
+    bool localTimetable = false;
+
+    // NVS and the panel come up on their own tasks. Only the network steps
+    // wait for WiFi, started below as soon as it is known to be needed. The
+    // panel starts as soon as a draw is known to be needed.
+    TaskGraph boot;
+    const int nvsStep = boot.add("nvs", loadRunCount, &numRuns);
+    int panelStep = -1;
+
+    // The drift-corrected clock, restored once for every offline check.
+    const bool hasTime = restoreTime(&timeInfo);
+    if (hasTime && DisplayInfoCache::isFresh(time(nullptr)) && DisplayInfoCache::load(DISPLAY_ID, manifest.display)
+        && manifest.display.numZones > 0)
     {
-        int waitTime = 60 - timeInfo.tm_sec;
-        Serial.print("Sleeping for ");
-        Serial.print(waitTime);
-        Serial.println("s for next minute");
-        delay(waitTime * 1000);
-        getCurrentTime(&timeInfo);
+        ZoneSchedule::begin(manifest.display.version);
+        if (!zonesNeedNetwork(manifest.display, time(nullptr)))
+        {
+            Serial.println("Only local zones are due, WiFi stays off.");
+            if (zonesDue(manifest.display, time(nullptr))) {
+                startPanel(boot, panelStep, &display);
+            }
+            hasConfig = true;
+            online = false;
+        }
     }
+#ifdef ENABLE_PLAYLIST_PREFETCH
+    if (online && hasTime && FrameCache::begin() && loadCachedManifest(manifest, time(nullptr)))
+    {
+        Serial.println("Showing prefetched frame, WiFi stays off.");
+        if (strcmp(manifest.current.etag, displayedEtag) != 0) {
+            startPanel(boot, panelStep, &display);
+        }
+        hasConfig = true;
+        online = false;
+    }
+#endif
+#ifdef ENABLE_LOCAL_TIMETABLE
+    if (online && hasTime && DeparturesDataset::isFresh(time(nullptr)) && DisplayInfoCache::load(DISPLAY_ID, manifest.display))
+    {
+        Serial.println("Rendering timetable from synced departures, WiFi stays off.");
+        startPanel(boot, panelStep, &display);
+        hasConfig = true;
+        online = false;
+        localTimetable = true;
+    }
+#endif
 
-    DisplayInfo displayInfo;
-    Display *display;
-    if (displayApiClient.getDisplayInfo(1, displayInfo))
+    if (online)
+    {
+        wentOnline = true;
+        beginWiFi(WIFI_SSID, WIFI_PASSWORD);
+        const int wifiStep = boot.add("wifi", joinWiFi, nullptr);
+        const int clockStep = boot.add("clock", syncClock, &timeInfo, TaskGraph::bit(wifiStep));
+        boot.wait(TaskGraph::bit(clockStep));
+        getCurrentTime(&timeInfo);
+
+#ifdef ENABLE_PLAYLIST_PREFETCH
+        hasConfig = prefetchPlaylist(manifest);
+        if (hasConfig)
+        {
+            // Everything left to do reads from flash.
+            flushUpdates();
+            disconnect();
+            online = false;
+        }
+#endif
+#ifdef ENABLE_LOCAL_TIMETABLE
+        localTimetable = DeparturesDataset::sync(displayApiClient, time(nullptr))
+                         && displayApiClient.getDisplayInfoCached(DISPLAY_ID, manifest.display, time(nullptr));
+        if (localTimetable && manifest.display.numZones > 0)
+        {
+            // The timetable is one zone among others, some may need WiFi.
+            localTimetable = false;
+            hasConfig = true;
+        }
+        else if (localTimetable)
+        {
+            startPanel(boot, panelStep, &display);
+            hasConfig = true;
+            flushUpdates();
+            disconnect();
+            online = false;
+        }
+#endif
+    }
+    if (!hasConfig)
+    {
+        hasConfig = displayApiClient.getManifest(DISPLAY_ID, manifest);
+        if (hasConfig)
+        {
+            DisplayInfoCache::store(manifest.display, time(nullptr));
+        }
+        else
+        {
+            Serial.println("No manifest available, falling back to display config.");
+            DisplayInfo displayInfo;
+            hasConfig = displayApiClient.getDisplayInfoCached(DISPLAY_ID, displayInfo, time(nullptr));
+            manifest.setDisplay(displayInfo);
+        }
+    }
+    const DisplayInfo &displayInfo = manifest.display;
+    boot.wait(TaskGraph::bit(nvsStep));
+    if (hasConfig)
     {
         Serial.println("Display Config:");
         Serial.print("Name: ");
-        Serial.println(displayInfo.name.c_str());
+        Serial.println(displayInfo.name);
         Serial.print("URL: ");
-        Serial.println(displayInfo.url.c_str());
+        Serial.println(displayInfo.url);
         Serial.print("Previous URL: ");
-        Serial.println(displayInfo.previousUrl.empty() ? "null" : displayInfo.previousUrl.c_str());
+        Serial.println(displayInfo.hasPreviousUrl() ? displayInfo.previousUrl : "null");
         Serial.print("Refresh Frequency: ");
         Serial.println(displayInfo.refreshFrequency);
         Serial.print("Full Refresh Frequency: ");
         Serial.println(displayInfo.fullRefreshFrequency);
         Serial.print("ID: ");
         Serial.println(displayInfo.id);
-
-        sendUpdate("Initializing display", UpdateStatus::PASS);
-
-        display = new Display();
-
-        initializeDisplay(display);
-        if (displayInfo.fullRefreshFrequency != -1 && numRuns % displayInfo.fullRefreshFrequency == 0) {
-          Serial.println("Clearing display due to full refresh frequency.");
-          display->clear();
-          Serial.println("Display cleared.");
+        Serial.print("Next change: ");
+        Serial.println((long)displayInfo.nextChange);
+
+        bool fullRefresh = displayInfo.fullRefreshFrequency != -1 && numRuns % displayInfo.fullRefreshFrequency == 0;
+        bool zoned = displayInfo.numZones > 0;
+        if (zoned)
+        {
+            ZoneSchedule::begin(displayInfo.version);
+            if (fullRefresh)
+            {
+                ZoneSchedule::invalidate();
+            }
+            if (!online && zonesNeedNetwork(displayInfo, time(nullptr)))
+            {
+                wentOnline = true;
+                online = connectToWiFi(WIFI_SSID, WIFI_PASSWORD);
+                if (!online)
+                {
+                    Serial.println("Could not connect to WiFi, drawing only local zones.");
+                    disconnect();
+                }
+            }
+        }
+        if (zoned && !zonesDue(displayInfo, time(nullptr)))
+        {
+            Serial.println("No zone due, skipping draw.");
+        }
+        else if (!zoned && !localTimetable && !fullRefresh && manifest.current.etag[0] != '\0' && strcmp(manifest.current.etag, displayedEtag) == 0)
+        {
+            Serial.println("Frame unchanged since last wake, skipping draw.");
+        }
+        else
+        {
+            sendUpdate("Initializing display", UpdateStatus::PASS);
+
+            startPanel(boot, panelStep, &display);
+            boot.wait(TaskGraph::bit(panelStep));
+
+            // Frames that fit next to the panel buffer are downloaded first,
+            // so the radio is off before the panel is cleared or drawn and
+            // never runs through a refresh.
+            MemoryReader previousFrame;
+            MemoryReader currentFrame;
+            if (online && !zoned && !localTimetable && bufferFrames(manifest, previousFrame, currentFrame)) {
+                flushUpdates();
+                disconnect();
+                online = false;
+            }
+
+            // Ready once everything but the refresh is done, which is
+            // when the deadline is meant to be met.
+            WakeScheduler::markReady(online, wentOnline);
+
+            if (fullRefresh) {
+              Serial.println("Clearing display due to full refresh frequency.");
+              display->clear();
+              Serial.println("Display cleared.");
+#ifdef ENABLE_LOCAL_TIMETABLE
+              DeparturesDataset::invalidate();
+#endif
+            }
+
+            if (zoned) {
+              Serial.println("Drawing due zones.");
+              drawZones(display, displayInfo, time(nullptr), online);
+              displayedEtag[0] = '\0';
+            } else
+#ifdef ENABLE_LOCAL_TIMETABLE
+            if (localTimetable) {
+              Serial.println("Rendering timetable.");
+              drawLocalTimetable(display, time(nullptr));
+              displayedEtag[0] = '\0';
+            } else
+#endif
+            {
+              Serial.println("Displaying image.");
+              if (drawImages(display, manifest, previousFrame, currentFrame)) {
+                strlcpy(displayedEtag, manifest.current.etag, sizeof(displayedEtag));
+              } else {
+                displayedEtag[0] = '\0';
+              }
+            }
         }
-
-        Serial.println("Displaying image.");
-        drawImages(display, displayInfo);
 
         numRuns++;
         if (numRuns >= 10000) {
@@ -186,25 +833,33 @@ void setup()
         preferences.putUInt(COUNTER_KEY, numRuns);
 
         preferences.end();
-        disconnect();
-        display->display.hibernate();
+        if (online) {
+          flushUpdates();
+          disconnect();
+        }
+        boot.wait(TaskGraph::bit(panelStep));
+        if (display) {
+          display->waitForRefresh();
+          display->display.hibernate();
+        }
 
-        enterDeepSleep(&timeInfo, displayInfo.refreshFrequency);
+        WakeScheduler::sleepUntil(WakeScheduler::nextDeadline(displayInfo.wakePeriod(), displayInfo.nextChange,
+                                                              displayInfo.wakeTimes, displayInfo.numWakeTimes));
     } else {
         Serial.println("Could not get display config.");
 
         sendUpdate("Could not get display config", UpdateStatus::ERROR);
 
         preferences.end();
+        flushUpdates();
         disconnect();
+        boot.wait(TaskGraph::bit(panelStep));
         if(display)
           display->display.hibernate();
 
         // Enter deep sleep for 5 minutes if config could not be fetched
-        esp_sleep_enable_timer_wakeup(300 * 1000000); // 5 minutes in microseconds
-        Serial.println("Entering deep sleep for 300s due to config failure");
-        Serial.end();
-        esp_deep_sleep_start();
+        Serial.println("Sleeping 300s due to config failure");
+        WakeScheduler::sleepFor(300);
     }
 }
 
@@ -0,0 +1,198 @@
+#include <DeparturesDataset.h>
+
+#include <esp_attr.h>
+
+#define DEPARTURES_VERSION 1
+#define DEPARTURES_HEADER_SIZE 12
+#define DEPARTURES_ENTRY_SIZE 6
+#define DEPARTURES_FLAG_CANCELED 0x01
+
+struct DeparturesState
+{
+    time_t syncedAt;
+    time_t validUntil;
+    time_t renderedAt;
+    uint16_t length;
+    uint8_t data[DEPARTURES_MAX_SIZE];
+};
+
+RTC_DATA_ATTR static DeparturesState departuresState = {};
+// A sync is received here, the dataset in use is only replaced once the
+// new one is known to be valid.
+static uint8_t received[DEPARTURES_MAX_SIZE];
+
+// Bounds checked little-endian cursor over the encoded dataset. Reads past
+// the end return zeros and mark the cursor as failed.
+class DeparturesDecoder
+{
+private:
+    const uint8_t *data;
+    size_t length;
+    size_t pos;
+    bool failed;
+
+public:
+    DeparturesDecoder(const uint8_t *data, size_t length) : data(data), length(length), pos(0), failed(false) {}
+
+    const uint8_t *take(size_t size)
+    {
+        if (failed || pos + size > length)
+        {
+            failed = true;
+            return nullptr;
+        }
+        const uint8_t *start = data + pos;
+        pos += size;
+        return start;
+    }
+
+    uint8_t read8()
+    {
+        const uint8_t *bytes = take(1);
+        return bytes ? bytes[0] : 0;
+    }
+
+    uint16_t read16()
+    {
+        const uint8_t *bytes = take(2);
+        return bytes ? bytes[0] | (uint16_t)bytes[1] << 8 : 0;
+    }
+
+    uint32_t read32()
+    {
+        const uint8_t *bytes = take(4);
+        return bytes ? bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24 : 0;
+    }
+
+    bool ok() const
+    {
+        return !failed;
+    }
+};
+
+struct DeparturesHeader
+{
+    time_t base;
+    time_t validUntil;
+};
+
+static bool readHeader(DeparturesDecoder &decoder, DeparturesHeader &header)
+{
+    const uint8_t *magic = decoder.take(3);
+    if (magic == nullptr || memcmp(magic, "DEP", 3) != 0 || decoder.read8() != DEPARTURES_VERSION)
+    {
+        return false;
+    }
+    header.base = decoder.read32();
+    header.validUntil = decoder.read32();
+    return decoder.ok();
+}
+
+bool DeparturesDataset::sync(DisplayApiClient &client, time_t now)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/gtfs/dataset/binary?n=%d&window=%d", TIMETABLE_ROWS, DEPARTURES_WINDOW);
+    int length = client.download(path, received, sizeof(received));
+
+    DeparturesDecoder decoder(received, length > 0 ? length : 0);
+    DeparturesHeader header;
+    if (length < DEPARTURES_HEADER_SIZE || !readHeader(decoder, header) || header.validUntil <= now)
+    {
+        // The previous dataset stays usable until it expires.
+        Serial.println("Could not sync departures dataset");
+        return false;
+    }
+    memcpy(departuresState.data, received, length);
+    departuresState.length = length;
+    departuresState.syncedAt = now;
+    departuresState.validUntil = header.validUntil;
+    // The displayed timetable cannot be rebuilt from the new dataset.
+    departuresState.renderedAt = 0;
+    Serial.print("Departures dataset of ");
+    Serial.print(length);
+    Serial.print(" bytes valid for ");
+    Serial.print((long)(header.validUntil - now));
+    Serial.println(" s");
+    return true;
+}
+
+bool DeparturesDataset::isFresh(time_t now)
+{
+    return departuresState.syncedAt > 0 && now >= departuresState.syncedAt && now < departuresState.validUntil
+           && now - departuresState.syncedAt < DEPARTURES_SYNC_PERIOD;
+}
+
+bool DeparturesDataset::load(Timetable &timetable, time_t now)
+{
+    timetable.reset(now);
+    if (departuresState.syncedAt == 0)
+    {
+        return false;
+    }
+
+    DeparturesDecoder decoder(departuresState.data, departuresState.length);
+    DeparturesHeader header;
+    if (!readHeader(decoder, header))
+    {
+        return false;
+    }
+    // Offsets in the timetable string pool, by index in the dataset.
+    uint16_t strings[UINT8_MAX];
+    uint8_t numStrings = decoder.read8();
+    for (uint8_t i = 0; i < numStrings; i++)
+    {
+        uint8_t length = decoder.read8();
+        const uint8_t *bytes = decoder.take(length);
+        strings[i] = bytes != nullptr ? timetable.intern(reinterpret_cast<const char *>(bytes), length) : Timetable::INVALID_STRING;
+    }
+
+    uint8_t numStops = decoder.read8();
+    for (uint8_t stop = 0; stop < numStops && decoder.ok(); stop++)
+    {
+        uint8_t nameIndex = decoder.read8();
+        uint8_t numEntries = decoder.read8();
+        if (nameIndex >= numStrings || !timetable.addStop(strings[nameIndex]))
+        {
+            break;
+        }
+        uint8_t numShown = 0;
+        for (uint8_t i = 0; i < numEntries && decoder.ok(); i++)
+        {
+            uint8_t lineIndex = decoder.read8();
+            uint8_t directionIndex = decoder.read8();
+            time_t departure = header.base + (time_t)decoder.read16() * 60;
+            int8_t delay = (int8_t)decoder.read8();
+            uint8_t flags = decoder.read8();
+            // Departures are listed until the end of their minute.
+            if (!decoder.ok() || lineIndex >= numStrings || directionIndex >= numStrings || departure + 60 <= now || numShown >= TIMETABLE_ROWS)
+            {
+                continue;
+            }
+            if (timetable.addEntry(stop, strings[lineIndex], strings[directionIndex], departure, delay, flags & DEPARTURES_FLAG_CANCELED))
+            {
+                numShown++;
+            }
+        }
+    }
+    if (!decoder.ok())
+    {
+        Serial.println("Departures dataset is truncated");
+    }
+    timetable.sort();
+    return !timetable.empty();
+}
+
+time_t DeparturesDataset::lastRendered()
+{
+    return departuresState.renderedAt;
+}
+
+void DeparturesDataset::markRendered(time_t now)
+{
+    departuresState.renderedAt = now;
+}
+
+void DeparturesDataset::invalidate()
+{
+    departuresState.renderedAt = 0;
+}
@@ -0,0 +1,150 @@
+#include <Timetable.h>
+
+Timetable::Timetable() : changes(0)
+{
+    reset(0);
+}
+
+void Timetable::reset(time_t referenceTime)
+{
+    stringsUsed = 0;
+    numEntries = 0;
+    numStops = 0;
+    this->referenceTime = referenceTime;
+    changes++;
+}
+
+uint16_t Timetable::intern(const char *text, size_t length)
+{
+    // Few distinct names per timetable, a linear scan is enough.
+    uint16_t offset = 0;
+    while (offset < stringsUsed)
+    {
+        size_t existingLength = strlen(strings + offset);
+        if (existingLength == length && memcmp(strings + offset, text, length) == 0)
+        {
+            return offset;
+        }
+        offset += existingLength + 1;
+    }
+    if (stringsUsed + length + 1 > TIMETABLE_STRING_POOL_SIZE)
+    {
+        return INVALID_STRING;
+    }
+    offset = stringsUsed;
+    memcpy(strings + offset, text, length);
+    strings[offset + length] = '\0';
+    stringsUsed += length + 1;
+    return offset;
+}
+
+const char *Timetable::string(uint16_t offset) const
+{
+    return offset < stringsUsed ? strings + offset : "";
+}
+
+bool Timetable::addStop(uint16_t name)
+{
+    if (numStops >= TIMETABLE_MAX_STOPS)
+    {
+        return false;
+    }
+    stops[numStops++] = {name, numEntries, 0};
+    changes++;
+    return true;
+}
+
+bool Timetable::addEntry(uint8_t stop, uint16_t line, uint16_t destination, time_t departure, int8_t delay, bool canceled)
+{
+    if (numEntries >= TIMETABLE_MAX_ENTRIES || stop >= numStops)
+    {
+        return false;
+    }
+    entries[numEntries++] = {stop, line, destination, departure, delay, canceled};
+    changes++;
+    return true;
+}
+
+void Timetable::sort()
+{
+    // Entries usually arrive in order already, which insertion sort handles
+    // in a single pass over contiguous memory.
+    for (uint16_t i = 1; i < numEntries; i++)
+    {
+        TimetableEntry entry = entries[i];
+        uint16_t j = i;
+        while (j > 0 && (entries[j - 1].stop > entry.stop || (entries[j - 1].stop == entry.stop && entries[j - 1].departure > entry.departure)))
+        {
+            entries[j] = entries[j - 1];
+            j--;
+        }
+        entries[j] = entry;
+    }
+
+    for (uint8_t i = 0; i < numStops; i++)
+    {
+        stops[i].numEntries = 0;
+    }
+    for (uint16_t i = numEntries; i > 0; i--)
+    {
+        TimetableStop &stop = stops[entries[i - 1].stop];
+        stop.firstEntry = i - 1;
+        stop.numEntries++;
+    }
+    // Stops without entries point at the end of the previous range.
+    uint16_t next = 0;
+    for (uint8_t i = 0; i < numStops; i++)
+    {
+        if (stops[i].numEntries == 0)
+        {
+            stops[i].firstEntry = next;
+        }
+        next = stops[i].firstEntry + stops[i].numEntries;
+    }
+    changes++;
+}
+
+uint8_t Timetable::stopCount() const
+{
+    return numStops;
+}
+
+const TimetableStop &Timetable::stop(uint8_t index) const
+{
+    return stops[index];
+}
+
+const TimetableEntry &Timetable::entry(uint16_t index) const
+{
+    return entries[index];
+}
+
+bool Timetable::empty() const
+{
+    return numStops == 0;
+}
+
+uint16_t Timetable::revision() const
+{
+    return changes;
+}
+
+void Timetable::formatTime(const TimetableEntry &entry, char *buffer, size_t size) const
+{
+    long minutesLeft = entry.departure > referenceTime ? (entry.departure - referenceTime) / 60 : 0;
+    if (minutesLeft < TIMETABLE_COUNTDOWN_MINUTES)
+    {
+        // The departure already includes the delay.
+        snprintf(buffer, size, "%ld'", minutesLeft);
+        return;
+    }
+    time_t scheduled = entry.departure - (time_t)entry.delay * 60;
+    tm scheduledTime;
+    localtime_r(&scheduled, &scheduledTime);
+    size_t length = strftime(buffer, size, "%H:%M", &scheduledTime);
+    // Same as the server renderer: delays of a minute or less are noise.
+    if (entry.delay > 1)
+    {
+        snprintf(buffer + length, size - length, "+%d", entry.delay);
+    }
+}
@@ -0,0 +1,305 @@
+#include <TimetableRenderer.h>
+
+TimetableRenderer::TimetableRenderer(Renderer &renderer, Timetable &timetable) : renderer(renderer), timetable(&timetable)
+{
+}
+
+void TimetableRenderer::setTimetable(Timetable &timetable)
+{
+    this->timetable = &timetable;
+}
+
+const char *TimetableRenderer::getLongestStopName()
+{
+    const char *longest = "";
+    uint16_t longestWidth = 0;
+    for (uint8_t i = 0; i < timetable->stopCount(); i++)
+    {
+        const char *name = timetable->string(timetable->stop(i).name);
+        uint16_t width = renderer.getStringWidth(name, headerFont);
+        if (width > longestWidth)
+        {
+            longest = name;
+            longestWidth = width;
+        }
+    }
+    return longest;
+}
+
+const char *TimetableRenderer::getLongestDestinationName()
+{
+    const char *longest = "";
+    uint16_t longestWidth = 0;
+    for (uint8_t i = 0; i < timetable->stopCount(); i++)
+    {
+        const TimetableStop &stop = timetable->stop(i);
+        for (uint16_t j = stop.firstEntry; j < stop.firstEntry + stop.numEntries; j++)
+        {
+            const char *destination = timetable->string(timetable->entry(j).destination);
+            uint16_t width = renderer.getStringWidth(destination, tableFont);
+            if (width > longestWidth)
+            {
+                longest = destination;
+                longestWidth = width;
+            }
+        }
+    }
+    return longest;
+}
+
+const TimetableLayout &TimetableRenderer::getLayout(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+    if (layout.timetable != timetable || layout.revision != timetable->revision() || layout.x != x || layout.y != y || layout.w != w || layout.h != h)
+    {
+        computeLayout(*timetable, layout, x, y, w, h);
+    }
+    return layout;
+}
+
+void TimetableRenderer::computeLayout(const Timetable &timetable, TimetableLayout &layout, uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+    layout.timetable = &timetable;
+    layout.revision = timetable.revision();
+    layout.x = x;
+    layout.y = y;
+    layout.w = w;
+    layout.h = h;
+    layout.fits = false;
+    if (timetable.empty())
+    {
+        return;
+    }
+
+    // Columns are shared by all stops, like on the server rendered timetable.
+    char time[TIMETABLE_TIME_SIZE];
+    uint16_t padding = max<uint16_t>(minimumPadding, w / 160);
+    uint16_t lineWidth = 0;
+    uint16_t timeWidth = 0;
+    uint16_t rowsPerStop = minimumCellsPerStop;
+    for (uint8_t i = 0; i < timetable.stopCount(); i++)
+    {
+        const TimetableStop &stop = timetable.stop(i);
+        rowsPerStop = max(rowsPerStop, stop.numEntries);
+        for (uint16_t j = stop.firstEntry; j < stop.firstEntry + stop.numEntries; j++)
+        {
+            const TimetableEntry &entry = timetable.entry(j);
+            timetable.formatTime(entry, time, sizeof(time));
+            lineWidth = max(lineWidth, renderer.getStringWidth(timetable.string(entry.line), tableFont));
+            timeWidth = max(timeWidth, renderer.getStringWidth(time, tableFont));
+        }
+    }
+    layout.padding = padding;
+    layout.lineX = x + padding;
+    layout.destinationX = layout.lineX + lineWidth + 2 * padding;
+    layout.timeX = x + w - padding - timeWidth;
+    int16_t destinationWidth = layout.timeX - layout.destinationX - padding;
+
+    // Heights without descenders so every row shares the same baseline.
+    uint16_t headerTextHeight = renderer.getStringHeight("0", headerFont);
+    layout.rowTextHeight = renderer.getStringHeight("0", tableFont);
+    layout.headerHeight = headerTextHeight + 2 * padding;
+    layout.stopHeight = h / timetable.stopCount();
+    if (destinationWidth <= 0 || layout.stopHeight <= layout.headerHeight)
+    {
+        Serial.println("Timetable does not fit in its bounds");
+        return;
+    }
+    layout.rowHeight = (layout.stopHeight - layout.headerHeight) / rowsPerStop;
+    if (layout.rowHeight < layout.rowTextHeight + minimumPadding)
+    {
+        Serial.println("Timetable rows do not fit in their bounds");
+        return;
+    }
+
+    for (uint8_t i = 0; i < timetable.stopCount(); i++)
+    {
+        const TimetableStop &stop = timetable.stop(i);
+        for (uint16_t j = stop.firstEntry; j < stop.firstEntry + stop.numEntries; j++)
+        {
+            bool truncated;
+            size_t length = renderer.fitPrefix(timetable.string(timetable.entry(j).destination), destinationWidth, tableFont, truncated);
+            layout.destinationLength[j] = min<size_t>(length, UINT8_MAX);
+            layout.destinationTruncated[j] = truncated;
+        }
+    }
+    layout.fits = true;
+}
+
+bool TimetableRenderer::drawTimetable(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+    if (timetable->empty())
+    {
+        return false;
+    }
+    const TimetableLayout &layout = getLayout(x, y, w, h);
+    if (!layout.fits)
+    {
+        return false;
+    }
+
+    char time[TIMETABLE_TIME_SIZE];
+    char destination[64];
+    int16_t stopY = y;
+    for (uint8_t i = 0; i < timetable->stopCount(); i++)
+    {
+        const TimetableStop &stop = timetable->stop(i);
+        renderer.drawString(x + w / 2, stopY + layout.padding, timetable->string(stop.name), headerFont, GxEPD_BLACK, CENTER, TOP);
+        int16_t rowY = stopY + layout.headerHeight;
+        for (uint16_t j = stop.firstEntry; j < stop.firstEntry + stop.numEntries; j++)
+        {
+            const TimetableEntry &entry = timetable->entry(j);
+            int16_t textY = rowY + (layout.rowHeight - layout.rowTextHeight) / 2;
+            Renderer::ellipsize(timetable->string(entry.destination), layout.destinationLength[j], layout.destinationTruncated[j], destination, sizeof(destination));
+            timetable->formatTime(entry, time, sizeof(time));
+            renderer.drawString(layout.lineX, textY, timetable->string(entry.line), tableFont);
+            renderer.drawString(layout.destinationX, textY, destination, tableFont);
+            renderer.drawString(layout.timeX, textY, time, tableFont);
+            if (entry.canceled)
+            {
+                int16_t middle = textY + layout.rowTextHeight / 2;
+                renderer.display.drawFastHLine(layout.lineX, middle, layout.timeX + renderer.getStringWidth(time, tableFont) - layout.lineX, GxEPD_BLACK);
+            }
+            rowY += layout.rowHeight;
+        }
+        stopY += layout.stopHeight;
+    }
+    return true;
+}
+
+uint8_t TimetableRenderer::diffRow(const Timetable &previous, const TimetableLayout &previousLayout, int16_t previousEntry, const TimetableLayout &layout, int16_t entry)
+{
+    static const uint8_t allColumns = 0b111;
+    if (previousEntry < 0 || entry < 0)
+    {
+        return previousEntry == entry ? 0 : allColumns;
+    }
+    const TimetableEntry &before = previous.entry(previousEntry);
+    const TimetableEntry &after = timetable->entry(entry);
+    if (before.canceled != after.canceled || after.canceled)
+    {
+        // The strike-through crosses every column.
+        return allColumns;
+    }
+    uint8_t columns = 0;
+    if (strcmp(previous.string(before.line), timetable->string(after.line)) != 0)
+    {
+        columns |= 0b001;
+    }
+    uint8_t length = layout.destinationLength[entry];
+    if (length != previousLayout.destinationLength[previousEntry] || layout.destinationTruncated[entry] != previousLayout.destinationTruncated[previousEntry] || memcmp(previous.string(before.destination), timetable->string(after.destination), length) != 0)
+    {
+        columns |= 0b010;
+    }
+    char beforeTime[TIMETABLE_TIME_SIZE];
+    char afterTime[TIMETABLE_TIME_SIZE];
+    previous.formatTime(before, beforeTime, sizeof(beforeTime));
+    timetable->formatTime(after, afterTime, sizeof(afterTime));
+    if (strcmp(beforeTime, afterTime) != 0)
+    {
+        columns |= 0b100;
+    }
+    return columns;
+}
+
+int TimetableRenderer::diff(const Timetable &previous, uint16_t x, uint16_t y, uint16_t w, uint16_t h, Bounds *windows, size_t capacity)
+{
+    const TimetableLayout &layout = getLayout(x, y, w, h);
+    TimetableLayout previousLayout;
+    computeLayout(previous, previousLayout, x, y, w, h);
+    if (!layout.fits || !previousLayout.fits || previous.stopCount() != timetable->stopCount() || previousLayout.lineX != layout.lineX || previousLayout.destinationX != layout.destinationX || previousLayout.timeX != layout.timeX || previousLayout.rowHeight != layout.rowHeight)
+    {
+        return -1;
+    }
+    for (uint8_t i = 0; i < timetable->stopCount(); i++)
+    {
+        if (strcmp(previous.string(previous.stop(i).name), timetable->string(timetable->stop(i).name)) != 0)
+        {
+            return -1;
+        }
+    }
+
+    // Cells span the columns edge to edge, so changed neighbours touch.
+    const int16_t columnX[] = {(int16_t)x, (int16_t)(layout.destinationX - layout.padding), (int16_t)(layout.timeX - layout.padding), (int16_t)(x + w)};
+    size_t count = 0;
+    bool overflow = false;
+    Bounds all = {};
+    // Rows with the same changed columns stack into one rectangle per run of
+    // columns. A departure shifts every row of its stop, which then becomes
+    // a single band.
+    uint8_t openColumns = 0;
+    int16_t openY = 0;
+    int16_t openBottom = 0;
+    auto flush = [&]()
+    {
+        for (uint8_t column = 0; column < 3 && openColumns != 0; column++)
+        {
+            if (!(openColumns & (1 << column)))
+            {
+                continue;
+            }
+            uint8_t last = column;
+            while (last + 1 < 3 && (openColumns & (1 << (last + 1))))
+            {
+                last++;
+            }
+            Bounds window = {columnX[column], openY, (uint16_t)(columnX[last + 1] - columnX[column]), (uint16_t)(openBottom - openY)};
+            if (count == 0 && !overflow)
+            {
+                all = window;
+            }
+            else
+            {
+                int16_t right = max<int16_t>(all.x + all.w, window.x + window.w);
+                int16_t bottom = max<int16_t>(all.y + all.h, window.y + window.h);
+                all.x = min(all.x, window.x);
+                all.y = min(all.y, window.y);
+                all.w = right - all.x;
+                all.h = bottom - all.y;
+            }
+            if (count < capacity)
+            {
+                windows[count++] = window;
+            }
+            else
+            {
+                overflow = true;
+            }
+            column = last;
+        }
+        openColumns = 0;
+    };
+
+    int16_t stopY = y;
+    for (uint8_t i = 0; i < timetable->stopCount(); i++)
+    {
+        const TimetableStop &before = previous.stop(i);
+        const TimetableStop &after = timetable->stop(i);
+        int16_t rowY = stopY + layout.headerHeight;
+        uint16_t rows = max(before.numEntries, after.numEntries);
+        for (uint16_t r = 0; r < rows; r++)
+        {
+            int16_t previousEntry = r < before.numEntries ? before.firstEntry + r : -1;
+            int16_t entry = r < after.numEntries ? after.firstEntry + r : -1;
+            uint8_t columns = diffRow(previous, previousLayout, previousEntry, layout, entry);
+            if (columns != openColumns || rowY != openBottom)
+            {
+                flush();
+                openColumns = columns;
+                openY = rowY;
+            }
+            rowY += layout.rowHeight;
+            openBottom = rowY;
+        }
+        stopY += layout.stopHeight;
+    }
+    flush();
+
+    if (overflow)
+    {
+        // Too many windows, one covering all of them, including those that
+        // did not fit.
+        windows[0] = all;
+        count = 1;
+    }
+    return count;
+}
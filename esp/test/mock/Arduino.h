@@ -0,0 +1,133 @@
+#ifndef MOCK_ARDUINO_H
+#define MOCK_ARDUINO_H
+
+// The parts of the Arduino core the host tests build against.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <arpa/inet.h>
+
+typedef bool boolean;
+
+#define HEX 16
+
+using std::max;
+using std::min;
+
+inline unsigned long millis()
+{
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+inline void delay(unsigned long ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+class MockSerial
+{
+public:
+    template <typename T>
+    void print(const T &value) { std::cout << value; }
+    template <typename T>
+    void println(const T &value) { std::cout << value << std::endl; }
+    template <typename T>
+    void println(const T &value, int base) { std::cout << (base == HEX ? std::hex : std::dec) << value << std::dec << std::endl; }
+    void println() { std::cout << std::endl; }
+};
+
+inline MockSerial Serial;
+
+class String
+{
+private:
+    std::string value;
+
+public:
+    String(const char *value = "") : value(value) {}
+    String(const std::string &value) : value(value) {}
+    const char *c_str() const { return value.c_str(); }
+    size_t length() const { return value.size(); }
+    bool startsWith(const String &prefix) const { return value.compare(0, prefix.value.size(), prefix.value) == 0; }
+    bool operator==(const String &other) const { return value == other.value; }
+};
+
+class IPAddress
+{
+private:
+    uint8_t bytes[4] = {};
+
+public:
+    IPAddress() {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : bytes{a, b, c, d} {}
+    // Takes IPv6 addresses too, without keeping them.
+    bool fromString(const char *address)
+    {
+        uint8_t v6[16];
+        return inet_pton(AF_INET, address, bytes) == 1 || inet_pton(AF_INET6, address, v6) == 1;
+    }
+    String toString() const
+    {
+        char text[16];
+        snprintf(text, sizeof(text), "%u.%u.%u.%u", bytes[0], bytes[1], bytes[2], bytes[3]);
+        return String(text);
+    }
+};
+
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t) = 0;
+};
+
+// Stream of the Arduino core: reads block until a byte or the timeout.
+class Stream : public Print
+{
+protected:
+    unsigned long _timeout = 1000;
+
+    int timedRead()
+    {
+        unsigned long start = millis();
+        do
+        {
+            int c = read();
+            if (c >= 0)
+                return c;
+        } while (millis() - start < _timeout);
+        return -1;
+    }
+
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long timeout) { _timeout = timeout; }
+
+    size_t readBytes(uint8_t *buffer, size_t length)
+    {
+        size_t count = 0;
+        while (count < length)
+        {
+            int c = timedRead();
+            if (c < 0)
+                break;
+            buffer[count++] = (uint8_t)c;
+        }
+        return count;
+    }
+    size_t readBytes(char *buffer, size_t length) { return readBytes((uint8_t *)buffer, length); }
+};
+
+#endif // MOCK_ARDUINO_H
@@ -0,0 +1,23 @@
+#ifndef MOCK_DISPLAY_API_CLIENT_H
+#define MOCK_DISPLAY_API_CLIENT_H
+
+#include <Arduino.h>
+
+// Serves `response` to every download, or fails like the real client when it
+// is not set or does not fit.
+class DisplayApiClient
+{
+public:
+    const uint8_t *response = nullptr;
+    size_t responseLength = 0;
+
+    int download(const char *path, uint8_t *buffer, size_t size)
+    {
+        if (response == nullptr || responseLength > size)
+            return -1;
+        memcpy(buffer, response, responseLength);
+        return responseLength;
+    }
+};
+
+#endif // MOCK_DISPLAY_API_CLIENT_H
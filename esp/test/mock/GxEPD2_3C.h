@@ -0,0 +1,180 @@
+#ifndef MOCK_GXEPD2_3C_H
+#define MOCK_GXEPD2_3C_H
+
+// Paged display over MockEpd, with GxEPD2's page loop: the last nextPage()
+// refreshes and returns once BUSY is released. The page buffer, the partial
+// window and drawPixel() follow GxEPD2_3C, members named alike, so Display
+// reaches them the same way.
+
+#include "MockEpd.h"
+
+#define GxEPD_BLACK 0x0000
+#define GxEPD_WHITE 0xFFFF
+#define GxEPD_DARKGREY 0x7BEF
+#define GxEPD_RED 0xF800
+#define GxEPD_YELLOW 0xFFE0
+#define GxEPD_COLORED GxEPD_RED
+#define GxEPD_GREEN 0x07E0
+#define GxEPD_BLUE 0x001F
+#define GxEPD_ORANGE 0xFC00
+
+template <typename Driver, uint16_t page_height>
+class GxEPD2_3C
+{
+private:
+    uint8_t _black_buffer[(Driver::WIDTH / 8) * page_height];
+    uint8_t _color_buffer[(Driver::WIDTH / 8) * page_height];
+    uint16_t _pw_x = 0, _pw_y = 0, _pw_w = Driver::WIDTH, _pw_h = Driver::HEIGHT;
+    int16_t _current_page = 0;
+    uint16_t _page_height = Driver::PAGE_HEIGHT;
+    uint8_t _rotation = 0;
+
+    void _rotate(uint16_t &x, uint16_t &y, uint16_t &w, uint16_t &h)
+    {
+        switch (_rotation)
+        {
+        case 1:
+            std::swap(x, y);
+            std::swap(w, h);
+            x = Driver::WIDTH - x - w;
+            break;
+        case 2:
+            x = Driver::WIDTH - x - w;
+            y = Driver::HEIGHT - y - h;
+            break;
+        case 3:
+            std::swap(x, y);
+            std::swap(w, h);
+            y = Driver::HEIGHT - y - h;
+            break;
+        }
+    }
+
+public:
+    Driver epd2;
+
+    GxEPD2_3C(const Driver &driver) : epd2(driver) {}
+
+    void init(uint32_t serialSpeed, bool initial, uint16_t resetDuration, bool pulldown) { epd2.command(); }
+    void setRotation(uint8_t rotation) { _rotation = rotation & 3; }
+    uint8_t getRotation() const { return _rotation; }
+    void setTextSize(uint8_t size) {}
+    void setTextColor(uint16_t color) {}
+    void setTextWrap(bool wrap) {}
+    int16_t width() const { return _rotation & 1 ? Driver::HEIGHT : Driver::WIDTH; }
+    int16_t height() const { return _rotation & 1 ? Driver::WIDTH : Driver::HEIGHT; }
+    uint16_t pageHeight() const { return _page_height; }
+    uint16_t pages() const { return (_pw_h + _page_height - 1) / _page_height; }
+
+    void fillScreen(uint16_t color)
+    {
+        uint8_t black = color == GxEPD_BLACK ? 0x00 : 0xFF;
+        uint8_t colored = color == GxEPD_RED || color == GxEPD_YELLOW ? 0x00 : 0xFF;
+        memset(_black_buffer, black, sizeof(_black_buffer));
+        memset(_color_buffer, colored, sizeof(_color_buffer));
+    }
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color)
+    {
+        if (x < 0 || x >= width() || y < 0 || y >= height())
+            return;
+        switch (_rotation)
+        {
+        case 1:
+            std::swap(x, y);
+            x = Driver::WIDTH - x - 1;
+            break;
+        case 2:
+            x = Driver::WIDTH - x - 1;
+            y = Driver::HEIGHT - y - 1;
+            break;
+        case 3:
+            std::swap(x, y);
+            y = Driver::HEIGHT - y - 1;
+            break;
+        }
+        x -= _pw_x;
+        y -= _pw_y;
+        if (x < 0 || x >= int16_t(_pw_w) || y < 0 || y >= int16_t(_pw_h))
+            return;
+        y -= _current_page * _page_height;
+        if (y < 0 || y >= int16_t(_page_height))
+            return;
+        uint32_t i = x / 8 + uint32_t(y) * (_pw_w / 8);
+        uint8_t bit = 1 << (7 - x % 8);
+        _black_buffer[i] |= bit;
+        _color_buffer[i] |= bit;
+        if (color == GxEPD_WHITE)
+            return;
+        else if (color == GxEPD_BLACK)
+            _black_buffer[i] &= ~bit;
+        else if (color == GxEPD_RED || color == GxEPD_YELLOW)
+            _color_buffer[i] &= ~bit;
+        else if ((color & 0xF800) > 0xF800 / 2)
+            _color_buffer[i] &= ~bit;
+        else if (((color & 0xF800) >> 11) + ((color & 0x07E0) >> 5) + (color & 0x001F) < 3 * 255 / 2)
+            _black_buffer[i] &= ~bit;
+    }
+
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+    {
+        for (int16_t row = y; row < y + h; row++)
+            for (int16_t col = x; col < x + w; col++)
+                drawPixel(col, row, color);
+    }
+
+    void setFullWindow()
+    {
+        _pw_x = 0;
+        _pw_y = 0;
+        _pw_w = Driver::WIDTH;
+        _pw_h = Driver::HEIGHT;
+    }
+
+    void setPartialWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+    {
+        _rotate(x, y, w, h);
+        _pw_x = std::min<uint16_t>(x, Driver::WIDTH);
+        _pw_y = std::min<uint16_t>(y, Driver::HEIGHT);
+        _pw_w = std::min<uint16_t>(w, Driver::WIDTH - _pw_x);
+        _pw_h = std::min<uint16_t>(h, Driver::HEIGHT - _pw_y);
+        // Byte aligned columns.
+        _pw_w += _pw_x % 8;
+        if (_pw_w % 8 > 0)
+            _pw_w += 8 - _pw_w % 8;
+        _pw_x -= _pw_x % 8;
+    }
+
+    void firstPage()
+    {
+        _current_page = 0;
+    }
+
+    bool nextPage()
+    {
+        epd2.writePage();
+        if (++_current_page < pages())
+            return true;
+        epd2.refresh();
+        _current_page = 0;
+        return false;
+    }
+
+    void clearScreen()
+    {
+        epd2.writePage();
+        epd2.refresh();
+    }
+
+    void refresh()
+    {
+        epd2.refresh();
+    }
+
+    void hibernate()
+    {
+        epd2.command();
+    }
+};
+
+#endif // MOCK_GXEPD2_3C_H
@@ -0,0 +1,28 @@
+#ifndef MOCK_HTTP_CLIENT_H
+#define MOCK_HTTP_CLIENT_H
+
+#include <NetworkClient.h>
+
+// Records what a request was bound to, sends nothing.
+class HTTPClient
+{
+public:
+    NetworkClient *client = nullptr;
+    String url;
+
+    bool begin(NetworkClient &client, const String &url)
+    {
+        this->client = &client;
+        this->url = url;
+        return true;
+    }
+    bool begin(const String &url)
+    {
+        client = nullptr;
+        this->url = url;
+        return true;
+    }
+    void addHeader(const String &name, const String &value) {}
+};
+
+#endif // MOCK_HTTP_CLIENT_H
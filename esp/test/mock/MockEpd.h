@@ -0,0 +1,103 @@
+#ifndef MOCK_EPD_H
+#define MOCK_EPD_H
+
+#include <Arduino.h>
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+
+struct GxEPD2
+{
+    enum Panel
+    {
+        GDEY075Z08,
+        ACeP730,
+        ACeP565,
+        GDEY073D46,
+        GDEM037F51
+    };
+};
+
+// Panel driver whose BUSY line follows a script: each refresh keeps it high
+// for the next scripted duration. Commands sent while it is high are
+// counted, the controller would ignore them.
+class MockEpd
+{
+private:
+    static std::mutex &scriptMutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+    static std::deque<uint32_t> &script()
+    {
+        static std::deque<uint32_t> durations;
+        return durations;
+    }
+    std::atomic<unsigned long> busyUntil{0};
+
+public:
+    static constexpr uint16_t WIDTH = 800;
+    static constexpr uint16_t HEIGHT = 480;
+    static constexpr uint16_t PAGE_HEIGHT = 160;
+    static constexpr uint32_t DEFAULT_BUSY_MS = 20;
+
+    const GxEPD2::Panel panel = GxEPD2::GDEY075Z08;
+    std::atomic<int> refreshes{0};
+    std::atomic<int> pagesWritten{0};
+    std::atomic<int> commandsWhileBusy{0};
+    std::atomic<unsigned long> lastRefreshEnd{0};
+
+    MockEpd(int16_t cs, int16_t dc, int16_t rst, int16_t busy) {}
+    MockEpd(const MockEpd &other) {}
+
+    // Durations, in ms, of the next refreshes.
+    static void scriptBusy(std::initializer_list<uint32_t> durations)
+    {
+        std::lock_guard<std::mutex> lock(scriptMutex());
+        script().assign(durations);
+    }
+
+    bool isBusy() const
+    {
+        return millis() < busyUntil;
+    }
+
+    void command()
+    {
+        if (isBusy())
+            commandsWhileBusy++;
+    }
+
+    void writePage()
+    {
+        command();
+        pagesWritten++;
+    }
+
+    // Starts the waveform and polls BUSY like GxEPD2, yielding in between.
+    void refresh()
+    {
+        command();
+        uint32_t duration = DEFAULT_BUSY_MS;
+        {
+            std::lock_guard<std::mutex> lock(scriptMutex());
+            if (!script().empty())
+            {
+                duration = script().front();
+                script().pop_front();
+            }
+        }
+        busyUntil = millis() + duration;
+        while (isBusy())
+            delay(1);
+        refreshes++;
+        lastRefreshEnd = millis();
+    }
+
+    void enableFastPartialMode() { command(); }
+    void disableFastPartialMode() { command(); }
+};
+
+#endif // MOCK_EPD_H
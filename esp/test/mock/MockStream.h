@@ -0,0 +1,23 @@
+#ifndef MOCK_STREAM_H
+#define MOCK_STREAM_H
+
+#include <Arduino.h>
+
+#include <string>
+
+// Socket stand-in serving `data`, then nothing: reads past it time out.
+class MockStream : public Stream
+{
+public:
+    std::string data;
+    size_t pos = 0;
+
+    MockStream(const std::string &data) : data(data) { setTimeout(10); }
+
+    int available() override { return data.size() - pos; }
+    int read() override { return pos < data.size() ? (uint8_t)data[pos++] : -1; }
+    int peek() override { return pos < data.size() ? (uint8_t)data[pos] : -1; }
+    size_t write(uint8_t) override { return 0; }
+};
+
+#endif // MOCK_STREAM_H
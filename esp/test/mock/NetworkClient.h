@@ -0,0 +1,25 @@
+#ifndef MOCK_NETWORK_CLIENT_H
+#define MOCK_NETWORK_CLIENT_H
+
+#include <Arduino.h>
+
+// The client interface of the Arduino core, connecting nowhere.
+class NetworkClient : public Stream
+{
+public:
+    virtual int connect(IPAddress ip, uint16_t port) { return 0; }
+    virtual int connect(IPAddress ip, uint16_t port, int32_t timeout) { return 0; }
+    virtual int connect(const char *host, uint16_t port) { return 0; }
+    virtual int connect(const char *host, uint16_t port, int32_t timeout) { return 0; }
+    size_t write(uint8_t data) override { return 0; }
+    virtual size_t write(const uint8_t *buf, size_t size) { return 0; }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    virtual int read(uint8_t *buf, size_t size) { return -1; }
+    int peek() override { return -1; }
+    virtual void flush() {}
+    virtual void stop() {}
+    virtual uint8_t connected() { return 0; }
+};
+
+#endif // MOCK_NETWORK_CLIENT_H
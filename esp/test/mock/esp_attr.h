@@ -0,0 +1,7 @@
+#ifndef MOCK_ESP_ATTR_H
+#define MOCK_ESP_ATTR_H
+
+// RTC memory is plain memory on the host, it lasts as long as the process.
+#define RTC_DATA_ATTR
+
+#endif // MOCK_ESP_ATTR_H
@@ -0,0 +1,8 @@
+#ifndef MOCK_ESP_CRT_BUNDLE_H
+#define MOCK_ESP_CRT_BUNDLE_H
+
+#include <mbedtls/ssl.h>
+
+inline int esp_crt_bundle_attach(void *conf) { return 0; }
+
+#endif // MOCK_ESP_CRT_BUNDLE_H
@@ -0,0 +1,43 @@
+#ifndef MOCK_FREERTOS_H
+#define MOCK_FREERTOS_H
+
+// Tasks run on threads and binary semaphores are condition variables.
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+typedef int BaseType_t;
+typedef uint32_t TickType_t;
+typedef void (*TaskFunction_t)(void *);
+typedef void *TaskHandle_t;
+
+#define pdPASS 1
+#define pdFAIL 0
+#define pdTRUE 1
+#define portMAX_DELAY UINT32_MAX
+
+struct MockTasks
+{
+    static bool &failCreate()
+    {
+        static bool fail = false;
+        return fail;
+    }
+};
+
+inline BaseType_t xTaskCreate(TaskFunction_t task, const char *name, uint32_t stackSize, void *arg, uint32_t priority, TaskHandle_t *handle)
+{
+    if (MockTasks::failCreate())
+        return pdFAIL;
+    std::thread(task, arg).detach();
+    return pdPASS;
+}
+
+// The task returns right after, which ends its thread.
+inline void vTaskDelete(TaskHandle_t task)
+{
+}
+
+#endif // MOCK_FREERTOS_H
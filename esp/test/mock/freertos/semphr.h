@@ -0,0 +1,42 @@
+#ifndef MOCK_SEMPHR_H
+#define MOCK_SEMPHR_H
+
+#include "FreeRTOS.h"
+
+struct MockSemaphore
+{
+    std::mutex mutex;
+    std::condition_variable given;
+    bool available = false;
+};
+
+typedef MockSemaphore *SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateBinary()
+{
+    return new MockSemaphore();
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    std::lock_guard<std::mutex> lock(semaphore->mutex);
+    semaphore->available = true;
+    semaphore->given.notify_all();
+    return pdTRUE;
+}
+
+// Only portMAX_DELAY is used by the firmware.
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks)
+{
+    std::unique_lock<std::mutex> lock(semaphore->mutex);
+    semaphore->given.wait(lock, [semaphore] { return semaphore->available; });
+    semaphore->available = false;
+    return pdTRUE;
+}
+
+inline void vSemaphoreDelete(SemaphoreHandle_t semaphore)
+{
+    delete semaphore;
+}
+
+#endif // MOCK_SEMPHR_H
@@ -0,0 +1,7 @@
+#ifndef MOCK_LWIP_SOCKETS_H
+#define MOCK_LWIP_SOCKETS_H
+
+#include <cerrno>
+#include <sys/socket.h>
+
+#endif // MOCK_LWIP_SOCKETS_H
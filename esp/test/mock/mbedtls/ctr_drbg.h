@@ -0,0 +1,7 @@
+#ifndef MOCK_MBEDTLS_CTR_DRBG_H
+#define MOCK_MBEDTLS_CTR_DRBG_H
+
+// Declared with the rest of the TLS stand-in.
+#include "ssl.h"
+
+#endif // MOCK_MBEDTLS_CTR_DRBG_H
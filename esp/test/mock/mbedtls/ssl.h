@@ -0,0 +1,180 @@
+#ifndef MOCK_MBEDTLS_SSL_H
+#define MOCK_MBEDTLS_SSL_H
+
+// Stand-in for the parts of mbed TLS the clients use. There is no network:
+// the handshake talks to mockTlsServer, which hands out numbered sessions
+// and resumes the one offered unless told to reject it.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#define MBEDTLS_SSL_SESSION_TICKETS
+
+#define MBEDTLS_ERR_SSL_WANT_READ -0x6900
+#define MBEDTLS_ERR_SSL_WANT_WRITE -0x6880
+#define MBEDTLS_ERR_SSL_HANDSHAKE_FAILURE -0x6E00
+#define MBEDTLS_ERR_SSL_BAD_INPUT_DATA -0x7100
+#define MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL -0x6A00
+#define MBEDTLS_ERR_NET_CONNECT_FAILED -0x0044
+
+#define MBEDTLS_NET_PROTO_TCP 0
+#define MBEDTLS_SSL_IS_CLIENT 0
+#define MBEDTLS_SSL_TRANSPORT_STREAM 0
+#define MBEDTLS_SSL_PRESET_DEFAULT 0
+#define MBEDTLS_SSL_VERIFY_REQUIRED 2
+#define MBEDTLS_SSL_SESSION_TICKETS_ENABLED 1
+
+struct MockTlsServer
+{
+    bool reachable = true;
+    bool acceptsResume = true;
+    uint32_t nextSession = 1;
+    // Of the last handshake.
+    std::string address;
+    bool sentHostname = false;
+    std::string hostname;
+    uint32_t offeredSession = 0;
+    // Since the last reset.
+    int handshakes = 0;
+    int resumed = 0;
+
+    void reset() { *this = MockTlsServer(); }
+};
+
+inline MockTlsServer mockTlsServer;
+
+struct mbedtls_net_context
+{
+    int fd;
+};
+
+struct mbedtls_entropy_context
+{
+};
+
+struct mbedtls_ctr_drbg_context
+{
+};
+
+struct mbedtls_x509_crt
+{
+};
+
+struct mbedtls_ssl_config
+{
+};
+
+struct mbedtls_ssl_session
+{
+    uint32_t id;
+};
+
+struct mbedtls_ssl_context
+{
+    bool hostnameSet;
+    std::string hostname;
+    uint32_t offered;
+    uint32_t session;
+};
+
+inline void mbedtls_net_init(mbedtls_net_context *net) { net->fd = -1; }
+inline void mbedtls_net_free(mbedtls_net_context *net) { net->fd = -1; }
+inline int mbedtls_net_connect(mbedtls_net_context *net, const char *host, const char *port, int proto)
+{
+    mockTlsServer.address = host;
+    return mockTlsServer.reachable ? 0 : MBEDTLS_ERR_NET_CONNECT_FAILED;
+}
+inline int mbedtls_net_set_nonblock(mbedtls_net_context *net) { return 0; }
+inline int mbedtls_net_send(void *net, const unsigned char *buf, size_t len) { return len; }
+inline int mbedtls_net_recv(void *net, unsigned char *buf, size_t len) { return MBEDTLS_ERR_SSL_WANT_READ; }
+inline int mbedtls_net_recv_timeout(void *net, unsigned char *buf, size_t len, uint32_t timeout) { return MBEDTLS_ERR_SSL_WANT_READ; }
+
+inline void mbedtls_entropy_init(mbedtls_entropy_context *entropy) {}
+inline void mbedtls_entropy_free(mbedtls_entropy_context *entropy) {}
+inline int mbedtls_entropy_func(void *entropy, unsigned char *output, size_t len) { return 0; }
+
+inline void mbedtls_ctr_drbg_init(mbedtls_ctr_drbg_context *drbg) {}
+inline void mbedtls_ctr_drbg_free(mbedtls_ctr_drbg_context *drbg) {}
+inline int mbedtls_ctr_drbg_seed(mbedtls_ctr_drbg_context *drbg, int (*entropy)(void *, unsigned char *, size_t), void *context, const unsigned char *custom, size_t len) { return 0; }
+inline int mbedtls_ctr_drbg_random(void *drbg, unsigned char *output, size_t len) { return 0; }
+
+inline void mbedtls_x509_crt_init(mbedtls_x509_crt *crt) {}
+inline void mbedtls_x509_crt_free(mbedtls_x509_crt *crt) {}
+inline int mbedtls_x509_crt_parse(mbedtls_x509_crt *crt, const unsigned char *buf, size_t len) { return 0; }
+
+inline void mbedtls_ssl_config_init(mbedtls_ssl_config *conf) {}
+inline void mbedtls_ssl_config_free(mbedtls_ssl_config *conf) {}
+inline int mbedtls_ssl_config_defaults(mbedtls_ssl_config *conf, int endpoint, int transport, int preset) { return 0; }
+inline void mbedtls_ssl_conf_ca_chain(mbedtls_ssl_config *conf, mbedtls_x509_crt *ca, void *crl) {}
+inline void mbedtls_ssl_conf_authmode(mbedtls_ssl_config *conf, int mode) {}
+inline void mbedtls_ssl_conf_rng(mbedtls_ssl_config *conf, int (*rng)(void *, unsigned char *, size_t), void *context) {}
+inline void mbedtls_ssl_conf_session_tickets(mbedtls_ssl_config *conf, int tickets) {}
+inline void mbedtls_ssl_conf_read_timeout(mbedtls_ssl_config *conf, uint32_t timeout) {}
+
+inline void mbedtls_ssl_init(mbedtls_ssl_context *ssl) { *ssl = mbedtls_ssl_context(); }
+inline void mbedtls_ssl_free(mbedtls_ssl_context *ssl) { *ssl = mbedtls_ssl_context(); }
+inline int mbedtls_ssl_setup(mbedtls_ssl_context *ssl, const mbedtls_ssl_config *conf) { return 0; }
+// nullptr clears the name: no SNI, no name check.
+inline int mbedtls_ssl_set_hostname(mbedtls_ssl_context *ssl, const char *hostname)
+{
+    ssl->hostnameSet = hostname != nullptr;
+    ssl->hostname = hostname != nullptr ? hostname : "";
+    return 0;
+}
+inline void mbedtls_ssl_set_bio(mbedtls_ssl_context *ssl, void *bio, int (*send)(void *, const unsigned char *, size_t), int (*recv)(void *, unsigned char *, size_t), int (*recvTimeout)(void *, unsigned char *, size_t, uint32_t)) {}
+
+inline int mbedtls_ssl_handshake(mbedtls_ssl_context *ssl)
+{
+    mockTlsServer.handshakes++;
+    mockTlsServer.sentHostname = ssl->hostnameSet;
+    mockTlsServer.hostname = ssl->hostname;
+    mockTlsServer.offeredSession = ssl->offered;
+    if (ssl->offered != 0)
+    {
+        if (!mockTlsServer.acceptsResume)
+        {
+            return MBEDTLS_ERR_SSL_HANDSHAKE_FAILURE;
+        }
+        mockTlsServer.resumed++;
+        ssl->session = ssl->offered;
+        return 0;
+    }
+    ssl->session = mockTlsServer.nextSession++;
+    return 0;
+}
+inline int mbedtls_ssl_read(mbedtls_ssl_context *ssl, unsigned char *buf, size_t len) { return MBEDTLS_ERR_SSL_WANT_READ; }
+inline int mbedtls_ssl_write(mbedtls_ssl_context *ssl, const unsigned char *buf, size_t len) { return len; }
+inline size_t mbedtls_ssl_get_bytes_avail(const mbedtls_ssl_context *ssl) { return 0; }
+inline int mbedtls_ssl_close_notify(mbedtls_ssl_context *ssl) { return 0; }
+
+inline void mbedtls_ssl_session_init(mbedtls_ssl_session *session) { session->id = 0; }
+inline void mbedtls_ssl_session_free(mbedtls_ssl_session *session) { session->id = 0; }
+inline int mbedtls_ssl_get_session(const mbedtls_ssl_context *ssl, mbedtls_ssl_session *session)
+{
+    session->id = ssl->session;
+    return ssl->session != 0 ? 0 : MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+}
+inline int mbedtls_ssl_set_session(mbedtls_ssl_context *ssl, const mbedtls_ssl_session *session)
+{
+    ssl->offered = session->id;
+    return 0;
+}
+inline int mbedtls_ssl_session_save(const mbedtls_ssl_session *session, unsigned char *buf, size_t len, size_t *olen)
+{
+    *olen = sizeof(session->id);
+    if (len < sizeof(session->id))
+        return MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL;
+    memcpy(buf, &session->id, sizeof(session->id));
+    return 0;
+}
+inline int mbedtls_ssl_session_load(mbedtls_ssl_session *session, const unsigned char *buf, size_t len)
+{
+    if (len != sizeof(session->id))
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    memcpy(&session->id, buf, sizeof(session->id));
+    return 0;
+}
+
+#endif // MOCK_MBEDTLS_SSL_H
@@ -0,0 +1,80 @@
+#include <ChunkedStream.h>
+#include <MockStream.h>
+#include <unity.h>
+
+#include <string>
+
+// Bodies as ChunkedStream hands them to ArduinoJson, followed by the next
+// response on the same connection.
+static const char NEXT_RESPONSE[] = "HTTP/1.1 200 OK\r\n";
+
+static std::string readAll(ChunkedStream &body)
+{
+    std::string text;
+    for (int c; (c = body.read()) >= 0;)
+    {
+        text += (char)c;
+    }
+    return text;
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_decodes_chunks()
+{
+    MockStream socket(std::string("7\r\n{\"a\":1,\r\n") + "A;name=value\r\n\"b\":[2,3]}\r\n" + "0\r\n\r\n" + NEXT_RESPONSE);
+    ChunkedStream body(socket, true);
+    TEST_ASSERT_EQUAL_STRING("{\"a\":1,\"b\":[2,3]}", readAll(body).c_str());
+    TEST_ASSERT_EQUAL_STRING(NEXT_RESPONSE, socket.data.substr(socket.pos).c_str());
+}
+
+void test_finish_skips_rest_and_trailers()
+{
+    MockStream socket(std::string("4\r\n{\"a\"\r\n3\r\n:1}\r\n0\r\nX-Trailer: 1\r\n\r\n") + NEXT_RESPONSE);
+    ChunkedStream body(socket, true);
+    TEST_ASSERT_EQUAL('{', body.peek());
+    TEST_ASSERT_EQUAL('{', body.read());
+    body.finish();
+    TEST_ASSERT_EQUAL(-1, body.read());
+    TEST_ASSERT_EQUAL_STRING(NEXT_RESPONSE, socket.data.substr(socket.pos).c_str());
+}
+
+void test_passes_through_unchunked_body()
+{
+    MockStream socket("{\"a\":1}");
+    ChunkedStream body(socket, false);
+    TEST_ASSERT_EQUAL(7, body.available());
+    TEST_ASSERT_EQUAL_STRING("{\"a\":1}", readAll(body).c_str());
+}
+
+void test_stops_on_truncated_body()
+{
+    MockStream socket("10\r\n{\"a\":1");
+    ChunkedStream body(socket, true);
+    TEST_ASSERT_EQUAL_STRING("{\"a\":1", readAll(body).c_str());
+    TEST_ASSERT_EQUAL(0, body.available());
+}
+
+void test_stops_on_malformed_size()
+{
+    MockStream socket("zz\r\n{}\r\n0\r\n\r\n");
+    ChunkedStream body(socket, true);
+    TEST_ASSERT_EQUAL(-1, body.read());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_decodes_chunks);
+    RUN_TEST(test_finish_skips_rest_and_trailers);
+    RUN_TEST(test_passes_through_unchunked_body);
+    RUN_TEST(test_stops_on_truncated_body);
+    RUN_TEST(test_stops_on_malformed_size);
+    return UNITY_END();
+}
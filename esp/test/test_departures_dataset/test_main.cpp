@@ -0,0 +1,146 @@
+#include <DeparturesDataset.h>
+#include <unity.h>
+
+#include <stdlib.h>
+
+// Payload of app/services/departures_encoding.py for a dataset generated at
+// BASE + 20 s and valid for 30 min:
+//   Gare:  1 Bel-Air +3 min, 1 Bel-Air +25 min delayed 2 min,
+//          17 Lausanne-Flon +40 min canceled
+//   Ouchy: M2 Croisettes +12 min delayed 1 min, M2 Croisettes +31 min
+static const time_t BASE = 1760000400; // 09:00 UTC
+static const uint8_t payload[] = {
+    0x44, 0x45, 0x50, 0x01, 0x90, 0x79, 0xE7, 0x68, 0x98, 0x80, 0xE7, 0x68,
+    0x08, 0x01, 0x31, 0x07, 0x42, 0x65, 0x6C, 0x2D, 0x41, 0x69, 0x72, 0x02,
+    0x31, 0x37, 0x0D, 0x4C, 0x61, 0x75, 0x73, 0x61, 0x6E, 0x6E, 0x65, 0x2D,
+    0x46, 0x6C, 0x6F, 0x6E, 0x04, 0x47, 0x61, 0x72, 0x65, 0x02, 0x4D, 0x32,
+    0x0A, 0x43, 0x72, 0x6F, 0x69, 0x73, 0x65, 0x74, 0x74, 0x65, 0x73, 0x05,
+    0x4F, 0x75, 0x63, 0x68, 0x79, 0x02, 0x04, 0x03, 0x00, 0x01, 0x03, 0x00,
+    0x00, 0x00, 0x00, 0x01, 0x19, 0x00, 0x02, 0x00, 0x02, 0x03, 0x28, 0x00,
+    0x00, 0x01, 0x07, 0x02, 0x05, 0x06, 0x0C, 0x00, 0x01, 0x00, 0x05, 0x06,
+    0x1F, 0x00, 0x00, 0x00,
+};
+
+struct Cell
+{
+    const char *stop;
+    const char *line;
+    const char *destination;
+    const char *time;
+    bool canceled;
+};
+
+static DisplayApiClient client;
+static Timetable timetable;
+
+static void assertCells(const Cell *cells, size_t numCells)
+{
+    size_t index = 0;
+    char time[TIMETABLE_TIME_SIZE];
+    for (uint8_t s = 0; s < timetable.stopCount(); s++)
+    {
+        const TimetableStop &stop = timetable.stop(s);
+        for (uint16_t i = stop.firstEntry; i < stop.firstEntry + stop.numEntries; i++, index++)
+        {
+            TEST_ASSERT_TRUE(index < numCells);
+            const TimetableEntry &entry = timetable.entry(i);
+            timetable.formatTime(entry, time, sizeof(time));
+            TEST_ASSERT_EQUAL_STRING(cells[index].stop, timetable.string(stop.name));
+            TEST_ASSERT_EQUAL_STRING(cells[index].line, timetable.string(entry.line));
+            TEST_ASSERT_EQUAL_STRING(cells[index].destination, timetable.string(entry.destination));
+            TEST_ASSERT_EQUAL_STRING(cells[index].time, time);
+            TEST_ASSERT_EQUAL(cells[index].canceled, entry.canceled);
+        }
+    }
+    TEST_ASSERT_EQUAL(numCells, index);
+}
+
+void setUp()
+{
+    setenv("TZ", "UTC0", 1);
+    tzset();
+    client.response = payload;
+    client.responseLength = sizeof(payload);
+    TEST_ASSERT_TRUE(DeparturesDataset::sync(client, BASE + 20));
+}
+
+void tearDown()
+{
+}
+
+// Past the countdown, times read as compute_time() in
+// app/renderer/timetable.py prints them.
+void test_load_matches_server_cells()
+{
+    const Cell cells[] = {
+        {"Gare", "1", "Bel-Air", "09:23+2", false},
+        {"Gare", "17", "Lausanne-Flon", "09:40", true},
+        {"Ouchy", "M2", "Croisettes", "7'", false},
+        {"Ouchy", "M2", "Croisettes", "09:31", false},
+    };
+    TEST_ASSERT_TRUE(DeparturesDataset::load(timetable, BASE + 5 * 60));
+    assertCells(cells, sizeof(cells) / sizeof(cells[0]));
+}
+
+void test_load_counts_down_close_departures()
+{
+    const Cell cells[] = {
+        {"Gare", "1", "Bel-Air", "2'", false},
+        {"Gare", "1", "Bel-Air", "09:23+2", false},
+        {"Gare", "17", "Lausanne-Flon", "09:40", true},
+        {"Ouchy", "M2", "Croisettes", "09:11", false},
+        {"Ouchy", "M2", "Croisettes", "09:31", false},
+    };
+    TEST_ASSERT_TRUE(DeparturesDataset::load(timetable, BASE + 20));
+    assertCells(cells, sizeof(cells) / sizeof(cells[0]));
+}
+
+void test_failed_sync_keeps_dataset()
+{
+    client.responseLength = 10;
+    TEST_ASSERT_FALSE(DeparturesDataset::sync(client, BASE + 60));
+    uint8_t corrupted[sizeof(payload)];
+    memcpy(corrupted, payload, sizeof(payload));
+    corrupted[0] = 'X';
+    client.response = corrupted;
+    client.responseLength = sizeof(corrupted);
+    TEST_ASSERT_FALSE(DeparturesDataset::sync(client, BASE + 60));
+    client.response = nullptr;
+    TEST_ASSERT_FALSE(DeparturesDataset::sync(client, BASE + 60));
+
+    TEST_ASSERT_TRUE(DeparturesDataset::load(timetable, BASE + 5 * 60));
+    TEST_ASSERT_EQUAL(2, timetable.stopCount());
+    TEST_ASSERT_EQUAL(2, timetable.stop(0).numEntries);
+}
+
+void test_expired_dataset_is_rejected()
+{
+    TEST_ASSERT_FALSE(DeparturesDataset::sync(client, BASE + 1800));
+    TEST_ASSERT_FALSE(DeparturesDataset::isFresh(BASE + 1800));
+}
+
+void test_sync_forgets_rendered_timetable()
+{
+    DeparturesDataset::markRendered(BASE + 30);
+    TEST_ASSERT_TRUE(DeparturesDataset::sync(client, BASE + 60));
+    TEST_ASSERT_EQUAL(0, DeparturesDataset::lastRendered());
+}
+
+void test_invalidate_forgets_rendered_timetable()
+{
+    DeparturesDataset::markRendered(BASE + 30);
+    DeparturesDataset::invalidate();
+    TEST_ASSERT_EQUAL(0, DeparturesDataset::lastRendered());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_load_matches_server_cells);
+    RUN_TEST(test_load_counts_down_close_departures);
+    RUN_TEST(test_failed_sync_keeps_dataset);
+    RUN_TEST(test_expired_dataset_is_rejected);
+    RUN_TEST(test_sync_forgets_rendered_timetable);
+    RUN_TEST(test_invalidate_forgets_rendered_timetable);
+    return UNITY_END();
+}
@@ -0,0 +1,116 @@
+#include <Display.h>
+#include <unity.h>
+
+// Page loops of Display against MockEpd, whose BUSY line follows a script.
+
+static Display *display;
+
+static MockEpd &panel()
+{
+    return display->display.epd2;
+}
+
+static void drawPages()
+{
+    do
+    {
+        display->display.fillScreen(GxEPD_WHITE);
+    } while (display->nextPage());
+}
+
+void setUp()
+{
+    MockTasks::failCreate() = false;
+    MockEpd::scriptBusy({});
+    display = new Display();
+    display->initDisplay();
+    display->setFullWindow();
+}
+
+void tearDown()
+{
+    display->waitForRefresh();
+    delete display;
+}
+
+void test_page_loop_returns_after_refresh()
+{
+    MockEpd::scriptBusy({60});
+    unsigned long start = millis();
+    display->firstPage();
+    drawPages();
+    TEST_ASSERT_EQUAL(1, panel().refreshes.load());
+    TEST_ASSERT_EQUAL(3, panel().pagesWritten.load());
+    TEST_ASSERT_GREATER_OR_EQUAL(60, millis() - start);
+}
+
+void test_async_refresh_returns_while_busy()
+{
+    MockEpd::scriptBusy({150});
+    unsigned long start = millis();
+    display->firstPage();
+    display->refreshAsync();
+    drawPages();
+    TEST_ASSERT_LESS_THAN(150, millis() - start);
+    TEST_ASSERT_EQUAL(0, panel().refreshes.load());
+
+    display->waitForRefresh();
+    TEST_ASSERT_EQUAL(1, panel().refreshes.load());
+    TEST_ASSERT_EQUAL(3, panel().pagesWritten.load());
+    TEST_ASSERT_GREATER_OR_EQUAL(150, millis() - start);
+}
+
+void test_panel_calls_wait_for_async_refresh()
+{
+    MockEpd::scriptBusy({100, 10});
+    display->firstPage();
+    display->refreshAsync();
+    drawPages();
+    display->clear();
+    TEST_ASSERT_EQUAL(2, panel().refreshes.load());
+    TEST_ASSERT_EQUAL(0, panel().commandsWhileBusy.load());
+}
+
+void test_first_page_drops_abandoned_request()
+{
+    MockEpd::scriptBusy({40, 40});
+    display->firstPage();
+    display->refreshAsync();
+    // A drawer throws before the last page.
+    display->nextPage();
+
+    display->firstPage();
+    drawPages();
+    TEST_ASSERT_EQUAL(1, panel().refreshes.load());
+}
+
+void test_cancel_refresh_async()
+{
+    display->firstPage();
+    display->refreshAsync();
+    display->cancelRefreshAsync();
+    drawPages();
+    TEST_ASSERT_EQUAL(1, panel().refreshes.load());
+}
+
+void test_refreshes_in_place_without_task()
+{
+    MockTasks::failCreate() = true;
+    display->firstPage();
+    display->refreshAsync();
+    drawPages();
+    TEST_ASSERT_EQUAL(1, panel().refreshes.load());
+    TEST_ASSERT_EQUAL(3, panel().pagesWritten.load());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_page_loop_returns_after_refresh);
+    RUN_TEST(test_async_refresh_returns_while_busy);
+    RUN_TEST(test_panel_calls_wait_for_async_refresh);
+    RUN_TEST(test_first_page_drops_abandoned_request);
+    RUN_TEST(test_cancel_refresh_async);
+    RUN_TEST(test_refreshes_in_place_without_task);
+    return UNITY_END();
+}
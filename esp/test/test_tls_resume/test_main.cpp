@@ -0,0 +1,104 @@
+#include <ResumableSecureClient.h>
+#include <unity.h>
+
+// Session resumption of ResumableSecureClient against the TLS stand-in of
+// test/mock/mbedtls: the session kept when a connection closes is offered
+// by the next one, and a rejected offer falls back to a full handshake.
+
+static const char *host = "display.example.org";
+
+void setUp()
+{
+    mockTlsServer.reset();
+    TlsSessionCache::invalidate();
+}
+
+void tearDown() {}
+
+void test_first_connection_caches_its_session()
+{
+    ResumableSecureClient client;
+    TEST_ASSERT_EQUAL(1, client.connect(host, 443));
+    TEST_ASSERT_EQUAL(0, mockTlsServer.offeredSession);
+    TEST_ASSERT_TRUE(mockTlsServer.sentHostname);
+    TEST_ASSERT_EQUAL_STRING(host, mockTlsServer.hostname.c_str());
+    client.stop();
+    TEST_ASSERT_TRUE(TlsSessionCache::has(host, 443));
+    TEST_ASSERT_FALSE(TlsSessionCache::has(host, 8443));
+}
+
+void test_next_connection_resumes()
+{
+    ResumableSecureClient client;
+    client.connect(host, 443);
+    client.stop();
+    TEST_ASSERT_EQUAL(1, client.connect(host, 443));
+    TEST_ASSERT_EQUAL(1, mockTlsServer.offeredSession);
+    TEST_ASSERT_EQUAL(1, mockTlsServer.resumed);
+    TEST_ASSERT_EQUAL(2, mockTlsServer.handshakes);
+}
+
+void test_rejected_resume_falls_back_to_full_handshake()
+{
+    ResumableSecureClient client;
+    client.connect(host, 443);
+    client.stop();
+    mockTlsServer.acceptsResume = false;
+    TEST_ASSERT_EQUAL(1, client.connect(host, 443));
+    // The offer, then a full handshake without it.
+    TEST_ASSERT_EQUAL(3, mockTlsServer.handshakes);
+    TEST_ASSERT_EQUAL(0, mockTlsServer.offeredSession);
+    TEST_ASSERT_EQUAL(0, mockTlsServer.resumed);
+    client.stop();
+    // The new session replaces the rejected one.
+    mockTlsServer.acceptsResume = true;
+    client.connect(host, 443);
+    TEST_ASSERT_EQUAL(2, mockTlsServer.offeredSession);
+    TEST_ASSERT_EQUAL(1, mockTlsServer.resumed);
+}
+
+void test_connection_error_keeps_session()
+{
+    ResumableSecureClient client;
+    client.connect(host, 443);
+    client.stop();
+    mockTlsServer.reachable = false;
+    TEST_ASSERT_EQUAL(0, client.connect(host, 443));
+    TEST_ASSERT_EQUAL(1, mockTlsServer.handshakes);
+    TEST_ASSERT_TRUE(TlsSessionCache::has(host, 443));
+}
+
+void test_ip_address_sends_no_hostname_nor_session()
+{
+    ResumableSecureClient client;
+    client.connect(host, 443);
+    client.stop();
+    TEST_ASSERT_EQUAL(1, client.connect(IPAddress(192, 168, 1, 10), 443));
+    TEST_ASSERT_EQUAL_STRING("192.168.1.10", mockTlsServer.address.c_str());
+    TEST_ASSERT_FALSE(mockTlsServer.sentHostname);
+    TEST_ASSERT_EQUAL(0, mockTlsServer.offeredSession);
+    client.stop();
+    TEST_ASSERT_FALSE(TlsSessionCache::has("192.168.1.10", 443));
+    TEST_ASSERT_TRUE(TlsSessionCache::has(host, 443));
+}
+
+void test_ip_address_in_url_is_not_a_hostname()
+{
+    ResumableSecureClient client;
+    TEST_ASSERT_EQUAL(1, client.connect("192.168.1.10", 443));
+    TEST_ASSERT_FALSE(mockTlsServer.sentHostname);
+    client.stop();
+    TEST_ASSERT_FALSE(TlsSessionCache::has("192.168.1.10", 443));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_first_connection_caches_its_session);
+    RUN_TEST(test_next_connection_resumes);
+    RUN_TEST(test_rejected_resume_falls_back_to_full_handshake);
+    RUN_TEST(test_connection_error_keeps_session);
+    RUN_TEST(test_ip_address_sends_no_hostname_nor_session);
+    RUN_TEST(test_ip_address_in_url_is_not_a_hostname);
+    return UNITY_END();
+}
@@ -1,24 +1,31 @@
 from datetime import date, datetime
-from typing import List
+from typing import List, Optional
 
-from fastapi import APIRouter, HTTPException, Query
+from fastapi import APIRouter, Header, HTTPException, Query, Request, Response
 
 from app.database.database import SessionDep
 from app.database.models.eink.display import DisplayCreate, DisplayPublic, DisplayUpdate
-from app.database.models.eink.update import UpdateCreate, UpdatePublic
+from app.database.models.eink.update import UpdateBatch, UpdateCreate, UpdatePublic
+from app.models.capabilities import CAPABILITIES_HEADER, DeviceCapabilities
+from app.models.manifest import Playlist, WakeManifest
 from app.services.display_service import (
     create_display,
     create_update,
+    create_updates,
     delete_display,
     get_display_by_id,
+    get_display_etag,
     get_displays,
     get_updates_by_display_id,
     remove_updates_before,
     update_display,
 )
+from app.services.manifest_service import build_manifest, build_playlist
 
 router = APIRouter(prefix="/eink/display", tags=["display"])
 
+CONFIG_VERSION_HEADER = "X-Config-Version"
+
 
 @router.get("", response_model=List[DisplayPublic])
 def get_displays_endpoint(
@@ -28,13 +35,58 @@ def get_displays_endpoint(
 
 
 @router.get("/{display_id}", response_model=DisplayPublic)
-def get_display_endpoint(display_id: int, session: SessionDep):
+def get_display_endpoint(
+    display_id: int,
+    response: Response,
+    session: SessionDep,
+    if_none_match: Optional[str] = Header(default=None),
+):
     display_db = get_display_by_id(session, display_id)
     if not display_db:
         raise HTTPException(404, f"Display with id {display_id} not found.")
+    etag = get_display_etag(display_db)
+    if if_none_match == etag:
+        return Response(status_code=304, headers={"ETag": etag})
+    response.headers["ETag"] = etag
     return display_db
 
 
+@router.get("/{display_id}/manifest", response_model=WakeManifest)
+def get_manifest_endpoint(
+    display_id: int,
+    request: Request,
+    session: SessionDep,
+    capabilities: Optional[str] = Header(default=None, alias=CAPABILITIES_HEADER),
+):
+    display_db = get_display_by_id(session, display_id)
+    if not display_db:
+        raise HTTPException(404, f"Display with id {display_id} not found.")
+    return build_manifest(
+        display_db,
+        lambda etag: str(request.url_for("get_frame_endpoint", etag=etag)),
+        DeviceCapabilities.parse(capabilities),
+    )
+
+
+@router.get("/{display_id}/playlist", response_model=Playlist)
+def get_playlist_endpoint(
+    display_id: int,
+    request: Request,
+    session: SessionDep,
+    length: int = Query(default=3, ge=1, le=8),
+    capabilities: Optional[str] = Header(default=None, alias=CAPABILITIES_HEADER),
+):
+    display_db = get_display_by_id(session, display_id)
+    if not display_db:
+        raise HTTPException(404, f"Display with id {display_id} not found.")
+    return build_playlist(
+        display_db,
+        lambda etag: str(request.url_for("get_frame_endpoint", etag=etag)),
+        length,
+        DeviceCapabilities.parse(capabilities),
+    )
+
+
 @router.post("", response_model=DisplayPublic)
 def create_display_endpoint(display: DisplayCreate, session: SessionDep):
     return create_display(session, display)
@@ -70,13 +122,28 @@ def get_update_endpoint(
 
 
 @router.post("/{display_id}/update", response_model=UpdatePublic)
-def create_update_endpoint(display_id: int, update: UpdateCreate, session: SessionDep):
+def create_update_endpoint(
+    display_id: int, update: UpdateCreate, response: Response, session: SessionDep
+):
     display_db = get_display_by_id(session, display_id)
     if not display_db:
         raise HTTPException(404, f"Display with id {display_id} not found.")
+    # Lets devices notice config changes without fetching the config.
+    response.headers[CONFIG_VERSION_HEADER] = str(display_db.version)
     return create_update(session, display_id, update)
 
 
+@router.post("/{display_id}/updates")
+def create_updates_endpoint(
+    display_id: int, batch: UpdateBatch, response: Response, session: SessionDep
+):
+    display_db = get_display_by_id(session, display_id)
+    if not display_db:
+        raise HTTPException(404, f"Display with id {display_id} not found.")
+    response.headers[CONFIG_VERSION_HEADER] = str(display_db.version)
+    return {"created": len(create_updates(session, display_id, batch))}
+
+
 @router.delete("/{display_id}/update")
 def remove_updates_endpoint(*, display_id: int, before: datetime, session: SessionDep):
     remove_updates_before(session, display_id, before)
@@ -0,0 +1,30 @@
+from fastapi import APIRouter, HTTPException, Response
+from fastapi.responses import FileResponse
+
+from app.services.format_service import (
+    FRAME_FORMAT_HEADER,
+    detect_format,
+    format_media_types,
+)
+from app.services.frame_service import get_frame_path
+
+router = APIRouter(prefix="/eink/frame", tags=["frame"])
+
+
+@router.get(
+    "/{etag}",
+    responses={
+        200: {"content": {media_type: {} for media_type in format_media_types.values()}}
+    },
+    response_class=Response,
+)
+def get_frame_endpoint(etag: str):
+    path = get_frame_path(etag)
+    if path is None:
+        raise HTTPException(404, f"Frame {etag} not found.")
+    frame_format = detect_format(path)
+    return FileResponse(
+        path,
+        media_type=format_media_types[frame_format],
+        headers={"ETag": f'"{etag}"', FRAME_FORMAT_HEADER: frame_format},
+    )
@@ -1,6 +1,11 @@
-from fastapi import APIRouter
+from fastapi import APIRouter, Response
 
-from app.services.gtfs_service import fetch_next_departures
+from app.models.timetable.dataset import DeparturesDataset
+from app.services.departures_encoding import (
+    DEPARTURES_MEDIA_TYPE,
+    encode_departures_dataset,
+)
+from app.services.gtfs_service import build_departures_dataset, fetch_next_departures
 
 router = APIRouter(prefix="/gtfs", tags=["gtfs"])
 
@@ -8,3 +13,20 @@ router = APIRouter(prefix="/gtfs", tags=["gtfs"])
 @router.get("/next")
 def get_gtfs_next_departures(n: int = 4):
     return fetch_next_departures(n)
+
+
+@router.get("/dataset", response_model=DeparturesDataset)
+def get_gtfs_departures_dataset(n: int = 4, window: int = 30):
+    return build_departures_dataset(n, window)
+
+
+@router.get(
+    "/dataset/binary",
+    responses={200: {"content": {DEPARTURES_MEDIA_TYPE: {}}}},
+    response_class=Response,
+)
+def get_gtfs_departures_dataset_binary(n: int = 4, window: int = 30):
+    return Response(
+        encode_departures_dataset(build_departures_dataset(n, window)),
+        media_type=DEPARTURES_MEDIA_TYPE,
+    )
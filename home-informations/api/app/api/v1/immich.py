@@ -1,9 +1,15 @@
+import io
 import logging
 import time
+from typing import Optional
 
-from fastapi import APIRouter, BackgroundTasks, HTTPException, Response
+from fastapi import APIRouter, BackgroundTasks, Header, HTTPException, Response
 from fastapi.responses import FileResponse
+from PIL import Image
 
+from app.models.capabilities import CAPABILITIES_HEADER, DeviceCapabilities
+from app.services.frame_service import FRAME_SEQUENCE_HEADER
+from app.services.image_processing_service import prepare_image_for_eink
 from app.services.immich_service import run_fill_cache
 from app.utils.immich_cache import ImmichCache, ImmichCacheDep
 
@@ -11,15 +17,23 @@ router = APIRouter(prefix="/immich", tags=["immich"])
 
 logger = logging.getLogger(__name__)
 
+# Every request pops the next cached picture.
+ROTATING_HEADERS = {FRAME_SEQUENCE_HEADER: "rotating"}
+
 def remove_from_cache(entry: ImmichCache.Entry, cache: ImmichCache):
     cache.cleanup(entry)
 
 @router.get(
     "/image",
-    responses={200: {"content": {"image/bmp": {}}}},
+    responses={200: {"content": {"image/bmp": {}, "image/jpeg": {}}}},
     response_class=Response,
 )
-def get_immich_image(*, cache: ImmichCacheDep, background_tasks: BackgroundTasks):
+def get_immich_image(
+    *,
+    cache: ImmichCacheDep,
+    background_tasks: BackgroundTasks,
+    capabilities: Optional[str] = Header(default=None, alias=CAPABILITIES_HEADER),
+):
     if cache.size() < 5:
         run_fill_cache(cache)
         time.sleep(2)
@@ -27,4 +41,14 @@ def get_immich_image(*, cache: ImmichCacheDep, background_tasks: BackgroundTasks
             raise HTTPException(503, "Cache is empty and Immich is unavailable")
     entry = cache.pop()
     background_tasks.add_task(remove_from_cache, entry=entry, cache=cache)
-    return FileResponse(entry.path, media_type="image/bmp")
+    if entry.path.endswith(".bmp"):
+        # Cached before images were kept undithered.
+        return FileResponse(entry.path, media_type="image/bmp", headers=ROTATING_HEADERS)
+    device = DeviceCapabilities.parse(capabilities)
+    if device is not None and "jpeg" in device.formats:
+        return FileResponse(entry.path, media_type="image/jpeg", headers=ROTATING_HEADERS)
+    with Image.open(entry.path) as image:
+        image = prepare_image_for_eink(image.convert("RGB"))
+    output = io.BytesIO()
+    image.save(output, "BMP")
+    return Response(output.getvalue(), media_type="image/bmp", headers=ROTATING_HEADERS)
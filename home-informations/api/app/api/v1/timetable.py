@@ -1,6 +1,7 @@
 from fastapi import APIRouter, Response
 from fastapi.responses import FileResponse
 
+from app.services.frame_service import NEXT_CHANGE_HEADER
 from app.services.timetable_service import (
     fetch_previous_timetable,
     generate_timetable,
@@ -23,12 +24,11 @@ def get_timetable(
     rotation: int = 0,
     key="timetable",
 ):
-    return FileResponse(
-        generate_timetable(
-            width, height, font_header_size, font_entries_size, n, rotation, key
-        ),
-        media_type="image/bmp",
+    image_path, next_change = generate_timetable(
+        width, height, font_header_size, font_entries_size, n, rotation, key
     )
+    headers = {NEXT_CHANGE_HEADER: str(next_change)} if next_change else None
+    return FileResponse(image_path, media_type="image/bmp", headers=headers)
 
 
 @router.get(
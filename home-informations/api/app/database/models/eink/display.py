@@ -1,11 +1,31 @@
 from typing import TYPE_CHECKING, List, Optional
-from sqlmodel import Field, Relationship, SQLModel
+from pydantic import model_validator
+from sqlmodel import JSON, Field, Relationship, SQLModel
 
 if TYPE_CHECKING:
     from .update import Update, UpdatePublic
 
 
 
+class Zone(SQLModel):
+    """A region of the display with its own content and cadence. The content
+    is either a bitmap `url` or a `renderer` the device runs locally, e.g.
+    "clock" or "timetable"."""
+    x: int = Field(ge=0)
+    y: int = Field(ge=0)
+    width: int = Field(gt=0)
+    height: int = Field(gt=0)
+    url: Optional[str] = None
+    renderer: Optional[str] = None
+    refresh_frequency: int = 60
+
+    @model_validator(mode="after")
+    def check_source(self):
+        if (self.url is None) == (self.renderer is None):
+            raise ValueError("A zone needs exactly one of url and renderer")
+        return self
+
+
 class DisplayBase(SQLModel):
     name: str = Field(index=True)
     url: str
@@ -16,18 +36,24 @@ class DisplayBase(SQLModel):
 
 class Display(DisplayBase, table=True):
     id: Optional[int] = Field(default=None, primary_key=True)
+    version: int = 1
+    # Stored as plain JSON, validated through Zone on the way in and out.
+    zones: Optional[List[dict]] = Field(default=None, sa_type=JSON)
     updates: List["Update"] = Relationship(back_populates="display", cascade_delete=True)
 
 class DisplayPublic(DisplayBase):
     id: int
+    version: int
+    zones: Optional[List[Zone]] = None
 
 class DisplayPublicWithUpdates(DisplayPublic):
     updates: List["UpdatePublic"] = []
 
 class DisplayCreate(DisplayBase):
-    pass
+    zones: Optional[List[Zone]] = None
 
 class DisplayUpdate(DisplayBase):
     name: Optional[str] = None
     url: Optional[str] = None
     refresh_frequency: Optional[int] = None
+    zones: Optional[List[Zone]] = None
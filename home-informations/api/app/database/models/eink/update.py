@@ -1,5 +1,5 @@
 from datetime import datetime, timezone
-from typing import TYPE_CHECKING, Optional
+from typing import TYPE_CHECKING, List, Optional
 from typing_extensions import Annotated
 
 from pydantic import AfterValidator, BeforeValidator, field_serializer
@@ -49,6 +49,16 @@ class UpdateCreate(UpdateBase):
     def serialize_status(self, status: str, _info):
         return Status.get_value(status)
 
+class UpdateBatchEntry(UpdateCreate):
+    # Seconds between the device queuing the update and sending the batch.
+    age: int = 0
+
+
+class UpdateBatch(SQLModel):
+    updates: List[UpdateBatchEntry] = []
+    dropped: int = 0
+
+
 class UpdateUpdate(UpdateBase):
     display_id: Optional[int] = None
     message: Optional[str] = None
@@ -8,6 +8,7 @@ from fastapi.concurrency import asynccontextmanager
 from fastapi.middleware.cors import CORSMiddleware
 
 from app.api.v1.display import router as display_router
+from app.api.v1.frame import router as frame_router
 from app.api.v1.gtfs import router as gtfs_router
 from app.api.v1.immich import router as immich_router
 from app.api.v1.timetable import router as timetable_router
@@ -75,4 +76,5 @@ api_v1_prefix = "/api/v1"
 app.include_router(gtfs_router, prefix=api_v1_prefix)
 app.include_router(timetable_router, prefix=api_v1_prefix)
 app.include_router(display_router, prefix=api_v1_prefix)
+app.include_router(frame_router, prefix=api_v1_prefix)
 app.include_router(immich_router, prefix=api_v1_prefix)
@@ -0,0 +1,60 @@
+from typing import List, Optional, Tuple
+
+from pydantic import BaseModel
+
+CAPABILITIES_HEADER = "X-Display-Capabilities"
+
+
+class DeviceCapabilities(BaseModel):
+    """What a device can draw, as advertised in its capabilities header, e.g.
+    "formats=bmp; panel=3c; driver=GxEPD2_750c_GDEY075Z08; size=800x480;
+    palette=000000,ffffff,ff0000"."""
+
+    formats: List[str] = []
+    panel: Optional[str] = None
+    driver: Optional[str] = None
+    size: Optional[Tuple[int, int]] = None
+    palette: List[Tuple[int, int, int]] = []
+
+    @classmethod
+    def parse(cls, header: Optional[str]) -> Optional["DeviceCapabilities"]:
+        """None for devices that do not send the header, which only know BMP."""
+        if not header:
+            return None
+        fields = {}
+        for part in header.split(";"):
+            key, _, value = part.partition("=")
+            fields[key.strip()] = value.strip()
+        capabilities = cls(
+            formats=[f for f in fields.get("formats", "").split(",") if f],
+            panel=fields.get("panel") or None,
+            driver=fields.get("driver") or None,
+        )
+        try:
+            width, height = fields.get("size", "").split("x")
+            capabilities.size = (int(width), int(height))
+        except ValueError:
+            pass
+        try:
+            capabilities.palette = [
+                (int(c[0:2], 16), int(c[2:4], 16), int(c[4:6], 16))
+                for c in fields.get("palette", "").split(",")
+                if len(c) == 6
+            ]
+        except ValueError:
+            pass
+        return capabilities
+
+    def to_header(self) -> str:
+        """Header value to forward to frame sources."""
+        parts = [f"formats={','.join(self.formats)}"]
+        if self.panel:
+            parts.append(f"panel={self.panel}")
+        if self.driver:
+            parts.append(f"driver={self.driver}")
+        if self.size:
+            parts.append(f"size={self.size[0]}x{self.size[1]}")
+        if self.palette:
+            colors = ",".join(f"{r:02x}{g:02x}{b:02x}" for r, g, b in self.palette)
+            parts.append(f"palette={colors}")
+        return "; ".join(parts)
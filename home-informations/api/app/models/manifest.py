@@ -0,0 +1,46 @@
+from typing import List, Optional
+
+from pydantic import BaseModel
+
+from app.database.models.eink.display import DisplayPublic
+
+
+class FrameCrop(BaseModel):
+    x: int
+    y: int
+    width: int
+    height: int
+
+
+class FramePosition(BaseModel):
+    x: int
+    y: int
+
+
+class FrameMetadata(BaseModel):
+    url: str
+    size: int
+    format: str
+    etag: str
+    # Set for patches: only the crop is drawn, at the position, and only
+    # those pixels are refreshed.
+    crop: Optional[FrameCrop] = None
+    position: Optional[FramePosition] = None
+
+
+class WakeManifest(BaseModel):
+    display: DisplayPublic
+    previous: Optional[FrameMetadata] = None
+    current: Optional[FrameMetadata] = None
+    next_change: Optional[int] = None
+    wake_times: List[int] = []
+
+
+class PlaylistEntry(FrameMetadata):
+    show_at: int
+
+
+class Playlist(BaseModel):
+    display: DisplayPublic
+    frames: List[PlaylistEntry] = []
+    valid_until: int
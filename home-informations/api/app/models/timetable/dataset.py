@@ -0,0 +1,25 @@
+from typing import List
+
+from pydantic import BaseModel
+
+
+class DepartureEntry(BaseModel):
+    line: str
+    direction: str
+    time: str
+    delay: int
+    is_canceled: bool
+    timestamp: int
+
+
+class StopDepartures(BaseModel):
+    stop: str
+    entries: List[DepartureEntry]
+
+
+class DeparturesDataset(BaseModel):
+    generated_at: int
+    # Until then every stop keeps at least `n` upcoming departures and the
+    # realtime delays are considered fresh enough.
+    valid_until: int
+    stops: List[StopDepartures]
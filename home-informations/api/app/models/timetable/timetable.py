@@ -1,5 +1,5 @@
 from dataclasses import dataclass
-from typing import List
+from typing import List, Optional
 
 
 @dataclass
@@ -9,6 +9,8 @@ class TimeTableEntry:
     time: str
     delay: int
     is_canceled: bool
+    # Adjusted departure as a unix timestamp
+    timestamp: Optional[int] = None
 
 
 @dataclass
@@ -1,4 +1,5 @@
 from dataclasses import dataclass
+from functools import lru_cache
 from typing import List, Tuple
 
 from PIL import Image, ImageDraw, ImageFont
@@ -20,8 +21,13 @@ class Bounds:
         return new_bounds
 
 
+@lru_cache(maxsize=1024)
+def _text_bbox(text: str, font) -> Tuple[int, int, int, int]:
+    return font.getbbox(text.encode("utf-8"), language="fr")
+
+
 def get_text_bounds(text: str, font):
-    left, top, right, bottom = font.getbbox(text.encode("utf-8"), language="fr")
+    left, top, right, bottom = _text_bbox(text, font)
     return Bounds(max(left, 0), max(top, 0), right - left, bottom - top)
 
 
@@ -30,12 +36,18 @@ def compute_time(entry: TimeTableEntry) -> str:
 
 
 def ellipsis_until_fit(text: str, font, width):
-    ellipsis = text
-    while (get_text_bounds(text, font).width > width) and len(ellipsis) > 0:
-        ellipsis = ellipsis[:-1]
-        # text = ellipsis + "..."
-        text = ellipsis + "…"
-    return text
+    if get_text_bounds(text, font).width <= width:
+        return text
+    # Longer prefixes are never narrower, so bisect for the longest one that
+    # still fits with the ellipsis. The empty prefix is the fallback.
+    low, high = 0, len(text) - 1
+    while low < high:
+        middle = (low + high + 1) // 2
+        if get_text_bounds(text[:middle] + "…", font).width <= width:
+            low = middle
+        else:
+            high = middle - 1
+    return text[:low] + "…"
 
 
 def compute_timetable_x_offsets(
@@ -0,0 +1,81 @@
+import struct
+from typing import Dict, List
+
+from app.models.timetable.dataset import DeparturesDataset
+
+# Compact encoding of a DeparturesDataset for the displays, all integers
+# little-endian:
+#
+#   magic "DEP" + version (u8)
+#   base (u32)          unix time, rounded down to the minute
+#   valid_until (u32)
+#   string count (u8), then per string: length (u8) + UTF-8 bytes
+#   stop count (u8), then per stop: name (u8 string index), entry count (u8)
+#     and per entry:
+#       line (u8 string index), direction (u8 string index)
+#       departure (u16) minutes after base, delay included
+#       delay (i8) minutes
+#       flags (u8) bit 0: canceled
+#
+# Strings are interned so a line or direction repeated across entries costs
+# a single byte after its first occurrence.
+DEPARTURES_MAGIC = b"DEP"
+DEPARTURES_VERSION = 1
+DEPARTURES_MEDIA_TYPE = "application/vnd.eink.departures"
+FLAG_CANCELED = 0x01
+MAX_STRING_LENGTH = 255
+MAX_COUNT = 255
+
+
+class StringPool:
+    def __init__(self):
+        self.strings: List[bytes] = []
+        self.indices: Dict[bytes, int] = {}
+
+    def intern(self, text: str) -> int:
+        encoded = text.encode("utf-8")[:MAX_STRING_LENGTH]
+        index = self.indices.get(encoded)
+        if index is None:
+            if len(self.strings) >= MAX_COUNT:
+                raise ValueError("Too many distinct strings to encode")
+            index = len(self.strings)
+            self.strings.append(encoded)
+            self.indices[encoded] = index
+        return index
+
+    def encode(self) -> bytes:
+        return struct.pack("<B", len(self.strings)) + b"".join(
+            struct.pack("<B", len(string)) + string for string in self.strings
+        )
+
+
+def encode_departures_dataset(dataset: DeparturesDataset) -> bytes:
+    base = dataset.generated_at - dataset.generated_at % 60
+    pool = StringPool()
+    stops = b""
+    stops_count = 0
+    for stop in dataset.stops[:MAX_COUNT]:
+        entries = b""
+        entries_count = 0
+        for entry in stop.entries[:MAX_COUNT]:
+            minutes = (entry.timestamp - base) // 60
+            if minutes < 0 or minutes > 0xFFFF:
+                continue
+            entries += struct.pack(
+                "<BBHbB",
+                pool.intern(entry.line),
+                pool.intern(entry.direction),
+                minutes,
+                max(-128, min(127, entry.delay)),
+                FLAG_CANCELED if entry.is_canceled else 0,
+            )
+            entries_count += 1
+        stops += struct.pack("<BB", pool.intern(stop.stop), entries_count) + entries
+        stops_count += 1
+    return (
+        DEPARTURES_MAGIC
+        + struct.pack("<BII", DEPARTURES_VERSION, base, dataset.valid_until)
+        + pool.encode()
+        + struct.pack("<B", stops_count)
+        + stops
+    )
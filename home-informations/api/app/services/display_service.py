@@ -1,8 +1,9 @@
-from datetime import datetime
+from datetime import datetime, timedelta, timezone
 from typing import List
 
 from app.database.models.eink.display import Display, DisplayCreate, DisplayUpdate
-from app.database.models.eink.update import Update, UpdateCreate
+from app.database.models.eink.status import Status
+from app.database.models.eink.update import Update, UpdateBatch, UpdateCreate
 from sqlmodel import Session, delete, select
 
 
@@ -15,7 +16,8 @@ def get_display_by_id(session: Session, display_id: int) -> Display | None:
 
 
 def create_display(session: Session, display: DisplayCreate) -> Display:
-    display_db = Display.model_validate(display)
+    # Dumped first so the zones reach the JSON column as plain dicts.
+    display_db = Display.model_validate(display.model_dump())
     session.add(display_db)
     session.commit()
     session.refresh(display_db)
@@ -29,12 +31,17 @@ def update_display(
     if display_db:
         display_data = display.model_dump(exclude_unset=True)
         display_db.sqlmodel_update(display_data)
+        display_db.version += 1
         session.add(display_db)
         session.commit()
         session.refresh(display_db)
     return display_db
 
 
+def get_display_etag(display: Display) -> str:
+    return f'"v{display.version}"'
+
+
 def delete_display(session: Session, display_id: int) -> bool:
     display_db = session.get(Display, display_id)
     if display_db:
@@ -73,6 +80,28 @@ def create_update(session: Session, display_id: int, update: UpdateCreate) -> Up
     return update_db
 
 
+def create_updates(session: Session, display_id: int, batch: UpdateBatch) -> List[Update]:
+    now = datetime.now(timezone.utc)
+    updates_db = []
+    for update in batch.updates:
+        update_data = update.model_dump(exclude_unset=True, exclude={"age"})
+        update_data["display_id"] = display_id
+        update_data["updated_datetime"] = now - timedelta(seconds=max(update.age, 0))
+        updates_db.append(Update(**update_data))
+    if batch.dropped > 0:
+        updates_db.append(
+            Update(
+                message=f"{batch.dropped} updates dropped on device",
+                status=Status.WARN.value,
+                display_id=display_id,
+                updated_datetime=now,
+            )
+        )
+    session.add_all(updates_db)
+    session.commit()
+    return updates_db
+
+
 def remove_updates_before(session: Session, display_id: int, before: datetime) -> None:
     session.exec(
         delete(Update)
@@ -0,0 +1,66 @@
+import hashlib
+import io
+import logging
+import os
+from dataclasses import replace
+from typing import Optional
+
+from PIL import Image
+
+from app.models.capabilities import DeviceCapabilities
+from app.services.frame_service import Frame, cleanup_frames, frames_path
+
+logger = logging.getLogger(__name__)
+
+FRAME_FORMAT_HEADER = "X-Frame-Format"
+
+# Targets when a frame has to be re-encoded, cheapest transfer first. Only
+# lossless ones: frames are already dithered to the panel palette.
+CONVERSION_FORMATS = ["png", "bmp"]
+
+pillow_formats = {"bmp": "BMP", "jpeg": "JPEG", "png": "PNG"}
+format_media_types = {"bmp": "image/bmp", "jpeg": "image/jpeg", "png": "image/png"}
+
+
+def detect_format(path: str) -> str:
+    with open(path, "rb") as f:
+        signature = f.read(8)
+    if signature.startswith(b"\xff\xd8"):
+        return "jpeg"
+    if signature.startswith(b"\x89PNG"):
+        return "png"
+    return "bmp"
+
+
+def choose_format(source: str, capabilities: Optional[DeviceCapabilities]) -> str:
+    """The frame's own format when the device decodes it, otherwise the first
+    conversion target it supports. Devices without capabilities get BMP."""
+    formats = capabilities.formats if capabilities else ["bmp"]
+    if source in formats:
+        return source
+    for target in CONVERSION_FORMATS:
+        if target in formats:
+            return target
+    return "bmp"
+
+
+def adapt_frame(frame: Frame, capabilities: Optional[DeviceCapabilities]) -> Frame:
+    """Re-encode `frame` into the format the device draws best, stored under
+    the hash of the new content like any other frame."""
+    target = choose_format(frame.format, capabilities)
+    if target == frame.format:
+        return frame
+    output = io.BytesIO()
+    with Image.open(frame.path) as image:
+        if target == "bmp" and image.mode not in ("1", "L", "P", "RGB"):
+            image = image.convert("RGB")
+        image.save(output, pillow_formats[target])
+    content = output.getvalue()
+    etag = hashlib.sha1(content).hexdigest()
+    path = os.path.join(frames_path, etag)
+    if not os.path.exists(path):
+        with open(path, "wb") as f:
+            f.write(content)
+        cleanup_frames()
+    logger.info(f"Converted frame {frame.etag} from {frame.format} to {target}")
+    return replace(frame, etag=etag, path=path, size=len(content), format=target)
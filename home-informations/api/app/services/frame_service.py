@@ -0,0 +1,117 @@
+import hashlib
+import logging
+import os
+import re
+from dataclasses import dataclass
+from typing import Dict, List, Optional
+
+import requests
+
+from app.config import settings
+from app.utils.helpers import create_folder_if_not_exists
+
+logger = logging.getLogger(__name__)
+
+frames_path = os.path.join(settings.data_dir, "frames")
+create_folder_if_not_exists(frames_path)
+
+etag_regex = re.compile(r"^[0-9a-f]{40}$")
+
+NEXT_CHANGE_HEADER = "X-Next-Change"
+WAKE_TIMES_HEADER = "X-Wake-Times"
+# Sources sending a patch: the part of the frame to draw, "x,y,width,height",
+# and where it goes on the panel, "x,y".
+FRAME_CROP_HEADER = "X-Frame-Crop"
+FRAME_POSITION_HEADER = "X-Frame-Position"
+# How the next frames of a source relate to this one: "static" when it always
+# serves the same frame, "rotating" when every request serves the next one.
+# Frames of sources without it depend on the time of the request.
+FRAME_SEQUENCE_HEADER = "X-Frame-Sequence"
+FRAME_SEQUENCES = ("static", "rotating")
+MAX_STORED_FRAMES = 32
+
+media_type_formats = {
+    "image/bmp": "bmp",
+    "image/jpeg": "jpeg",
+    "image/png": "png",
+}
+
+
+@dataclass
+class Frame:
+    etag: str
+    path: str
+    size: int
+    format: str
+    next_change: Optional[int] = None
+    wake_times: Optional[List[int]] = None
+    crop: Optional[List[int]] = None
+    position: Optional[List[int]] = None
+    sequence: Optional[str] = None
+
+
+def parse_ints(value: Optional[str], count: int) -> Optional[List[int]]:
+    """`count` comma separated integers, None when missing or malformed."""
+    if not value:
+        return None
+    try:
+        numbers = [int(part) for part in value.split(",")]
+    except ValueError:
+        return None
+    return numbers if len(numbers) == count else None
+
+
+def materialize_frame(
+    url: str, timeout: int = 30, headers: Optional[Dict[str, str]] = None
+) -> Optional[Frame]:
+    """Fetch the frame behind `url` and store it under its content hash so the
+    device can download it from the same connection as the manifest."""
+    try:
+        response = requests.get(url, timeout=timeout, headers=headers)
+    except requests.RequestException as e:
+        logger.error(f"Could not fetch frame from {url}: {e}")
+        return None
+    if response.status_code != 200:
+        logger.error(f"Could not fetch frame from {url}: {response.status_code}")
+        return None
+
+    etag = hashlib.sha1(response.content).hexdigest()
+    path = os.path.join(frames_path, etag)
+    if not os.path.exists(path):
+        with open(path, "wb") as f:
+            f.write(response.content)
+        cleanup_frames()
+    else:
+        os.utime(path)
+
+    media_type = response.headers.get("Content-Type", "").split(";")[0].strip()
+    next_change = response.headers.get(NEXT_CHANGE_HEADER)
+    wake_times = response.headers.get(WAKE_TIMES_HEADER)
+    sequence = response.headers.get(FRAME_SEQUENCE_HEADER)
+    return Frame(
+        etag,
+        path,
+        len(response.content),
+        media_type_formats.get(media_type, "bmp"),
+        int(next_change) if next_change else None,
+        [int(t) for t in wake_times.split(",") if t.strip()] if wake_times else None,
+        parse_ints(response.headers.get(FRAME_CROP_HEADER), 4),
+        parse_ints(response.headers.get(FRAME_POSITION_HEADER), 2),
+        sequence if sequence in FRAME_SEQUENCES else None,
+    )
+
+
+def get_frame_path(etag: str) -> Optional[str]:
+    if etag_regex.match(etag) is None:
+        return None
+    path = os.path.join(frames_path, etag)
+    return path if os.path.exists(path) else None
+
+
+def cleanup_frames(keep: int = MAX_STORED_FRAMES):
+    files = sorted(
+        (os.path.join(frames_path, name) for name in os.listdir(frames_path)),
+        key=os.path.getmtime,
+    )
+    for path in files[:-keep]:
+        os.remove(path)
@@ -1,10 +1,12 @@
 import os
+import time
 
 from app.config import settings
 from app.models.gtfs.config import local_stops_ids
 from app.models.gtfs.format import get_nth_next_departures
 from app.models.gtfs.gtfs_dataset import GtfsDataset
 from app.models.gtfs.gtfs_realtime import GtfsRealtime
+from app.models.timetable.dataset import DeparturesDataset
 from app.utils.helpers import map_group_row
 
 dataset = GtfsDataset(os.path.join(settings.data_dir, "gtfs"))
@@ -28,3 +30,30 @@ def fetch_next_departures(n: int = 4):
         .to_dict()
         .items()
     ]
+
+
+def build_departures_dataset(n: int = 4, window: int = 30) -> DeparturesDataset:
+    """Departures for the next `window` minutes, so a display can render its
+    timetable locally on every wake and only sync once in a while."""
+    now = int(time.time())
+    horizon = now + window * 60
+    # Over-fetch: departed entries are dropped by the display as time passes.
+    stops = [
+        {
+            "stop": departures["stop"],
+            "entries": [
+                entry
+                for index, entry in enumerate(departures["entries"])
+                if index < n or entry["timestamp"] <= horizon
+            ],
+        }
+        for departures in fetch_next_departures(n * 4)
+    ]
+    valid_until = horizon
+    for stop in stops:
+        if len(stop["entries"]) > n:
+            # Departures are listed until the end of their minute.
+            valid_until = min(
+                valid_until, stop["entries"][len(stop["entries"]) - n]["timestamp"] + 60
+            )
+    return DeparturesDataset(generated_at=now, valid_until=valid_until, stops=stops)
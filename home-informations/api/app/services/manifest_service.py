@@ -0,0 +1,111 @@
+import time
+from typing import Callable, Optional
+
+from app.database.models.eink.display import Display, DisplayPublic
+from app.models.capabilities import CAPABILITIES_HEADER, DeviceCapabilities
+from app.models.manifest import (
+    FrameCrop,
+    FrameMetadata,
+    FramePosition,
+    Playlist,
+    PlaylistEntry,
+    WakeManifest,
+)
+from app.services.format_service import adapt_frame
+from app.services.frame_service import Frame, materialize_frame
+
+
+def to_frame_metadata(
+    frame: Optional[Frame], frame_url: Callable[[str], str]
+) -> Optional[FrameMetadata]:
+    if frame is None:
+        return None
+    crop = (
+        FrameCrop(x=frame.crop[0], y=frame.crop[1], width=frame.crop[2], height=frame.crop[3])
+        if frame.crop
+        else None
+    )
+    position = (
+        FramePosition(x=frame.position[0], y=frame.position[1]) if frame.position else None
+    )
+    return FrameMetadata(
+        url=frame_url(frame.etag),
+        size=frame.size,
+        format=frame.format,
+        etag=frame.etag,
+        crop=crop,
+        position=position,
+    )
+
+
+def materialize_for(
+    url: str, capabilities: Optional[DeviceCapabilities]
+) -> Optional[Frame]:
+    # Sources like the Immich endpoint pick their format from the device's.
+    headers = {CAPABILITIES_HEADER: capabilities.to_header()} if capabilities else None
+    frame = materialize_frame(url, headers=headers)
+    return adapt_frame(frame, capabilities) if frame else None
+
+
+def build_manifest(
+    display: Display,
+    frame_url: Callable[[str], str],
+    capabilities: Optional[DeviceCapabilities] = None,
+) -> WakeManifest:
+    current = materialize_for(display.url, capabilities)
+    previous = (
+        materialize_for(display.previous_url, capabilities)
+        if display.previous_url
+        else None
+    )
+    return WakeManifest(
+        display=DisplayPublic.model_validate(display),
+        previous=to_frame_metadata(previous, frame_url),
+        current=to_frame_metadata(current, frame_url),
+        next_change=current.next_change if current else None,
+        wake_times=(current.wake_times or []) if current else [],
+    )
+
+
+def build_playlist(
+    display: Display,
+    frame_url: Callable[[str], str],
+    length: int,
+    capabilities: Optional[DeviceCapabilities] = None,
+) -> Playlist:
+    """Materialize the next `length` frames of the display, one per refresh
+    period, so the device can download them all in a single radio session.
+    The first frame is due right away, the others on period boundaries.
+
+    Only rotating sources serve their next frame on every request. A static
+    source lists its frame once for the whole playlist, and any other source
+    only its current frame, valid until it announces a change."""
+    period = display.refresh_frequency if display.refresh_frequency > 0 else 60
+    now = int(time.time())
+    next_boundary = (now // period + 1) * period
+    frame = materialize_for(display.url, capabilities)
+    frames = []
+    while frame is not None:
+        show_at = now if len(frames) == 0 else next_boundary + (len(frames) - 1) * period
+        frames.append(
+            PlaylistEntry(
+                **to_frame_metadata(frame, frame_url).model_dump(), show_at=show_at
+            )
+        )
+        if frame.sequence != "rotating" or len(frames) >= length:
+            break
+        frame = materialize_for(display.url, capabilities)
+
+    if not frames:
+        valid_until = now
+    elif frame is not None and frame.sequence == "static":
+        valid_until = next_boundary + (length - 1) * period
+    elif frame is not None and frame.sequence is None:
+        valid_until = frame.next_change if frame.next_change and frame.next_change > now else next_boundary
+    else:
+        valid_until = frames[-1].show_at + period
+    return Playlist(
+        display=DisplayPublic.model_validate(display),
+        frames=frames,
+        valid_until=max(valid_until, next_boundary),
+    )
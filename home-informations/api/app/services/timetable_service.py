@@ -1,7 +1,8 @@
 import os
 import re
-from datetime import datetime
+from datetime import datetime, timedelta
 from pathlib import Path
+from typing import List, Optional, Tuple
 
 from PIL import Image
 
@@ -14,6 +15,30 @@ timetable_cache_path = os.path.join(settings.data_dir, "timetable_cache")
 if not os.path.exists(timetable_cache_path):
     os.makedirs(timetable_cache_path, exist_ok=True)
 
+# How far ahead realtime delays are worth waking a display for.
+REALTIME_HORIZON = timedelta(minutes=5)
+
+
+def compute_next_change(timetables: List[TimeTable]) -> Optional[int]:
+    """Time at which the rendered timetable will next change: when the first
+    departure leaves the table, or when a departure enters the realtime
+    horizon. None while a departure is inside the horizon, so the display
+    polls at its refresh frequency and picks up every delay update."""
+    now = datetime.now()
+    # Departures are listed until the end of their minute.
+    departures = [
+        datetime.fromtimestamp(entry.timestamp) + timedelta(minutes=1)
+        for timetable in timetables
+        for entry in timetable.entries
+        if entry.timestamp is not None
+    ]
+    departures = [departure for departure in departures if departure > now]
+    if len(departures) == 0:
+        return None
+    if any(departure - REALTIME_HORIZON <= now for departure in departures):
+        return None
+    return int((min(departures) - REALTIME_HORIZON).timestamp())
+
 
 def generate_timetable(
     width: int,
@@ -23,7 +48,7 @@ def generate_timetable(
     n: int,
     rotation: int,
     key: str,
-) -> str:
+) -> Tuple[str, Optional[int]]:
     timetables = [
         TimeTable(
             departures["stop"],
@@ -52,7 +77,7 @@ def generate_timetable(
     image_name = datetime.now().strftime(f"{key}_%Y%m%d%H%M%S%f.bmp")
     image_path = os.path.join(timetable_cache_path, image_name)
     canvas.rotate(rotation, expand=True).save(image_path, format="BMP")
-    return image_path
+    return image_path, compute_next_change(timetables)
 
 
 def fetch_previous_timetable(width: int, height: int, rotation: int, key: str) -> str:
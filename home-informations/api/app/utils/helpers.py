@@ -3,6 +3,7 @@ import io
 import logging
 import os
 import shutil
+import time
 import zipfile
 from datetime import datetime, timedelta
 
@@ -59,6 +60,14 @@ def get_tomorrow():
     return get_today() + timedelta(days=1)
 
 
+def local_timestamp(value: datetime) -> int:
+    """Unix time of `value`, naive values being in the server's time zone.
+    pandas would take a naive Timestamp for UTC."""
+    if value.tzinfo is not None:
+        return int(value.timestamp())
+    return int(time.mktime(value.timetuple()))
+
+
 def map_group_row(row):
     return {
         "line": row["route_short_name"],
@@ -66,6 +75,7 @@ def map_group_row(row):
         "time": row["departure_timestamp"].strftime("%H:%M"),
         "delay": row["departure_delay"],
         "is_canceled": row["is_canceled"],
+        "timestamp": local_timestamp(row["adjusted_departure_timestamp"]),
     }
 
 
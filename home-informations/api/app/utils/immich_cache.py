@@ -12,7 +12,7 @@ from ulid import ULID
 
 from app.config import settings
 from app.models.immich import ImmichClient
-from app.services.image_processing_service import crop_image, prepare_image_for_eink
+from app.services.image_processing_service import crop_image
 from app.utils.helpers import human_readable_to_bytes, remove_empty_folders
 
 filename_regex = re.compile(
@@ -54,12 +54,13 @@ class ImmichCache:
         if image.height > image.width:
             image = image.transpose(Image.Transpose.ROTATE_90)
         ulid = str(ULID())
-        filename = f"{ulid}_{immich_uuid}.bmp"
+        # Kept undithered: devices with a JPEG decoder dither to their own
+        # palette, the others get a BMP dithered when the image is served.
+        filename = f"{ulid}_{immich_uuid}.jpg"
         path = os.path.join(self.base_dir, filename)
         if image.mode != "RGB":
             image = image.convert("RGB")
-        image = prepare_image_for_eink(image)
-        image.save(path, "BMP")
+        image.save(path, "JPEG", quality=90)
         file_size = os.stat(path).st_size
         removed_image = self.make_space_for(file_size)
         self.cache_files[immich_uuid] = ImmichCache.Entry(ulid, immich_uuid, path)
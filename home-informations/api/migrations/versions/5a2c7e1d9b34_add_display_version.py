@@ -0,0 +1,27 @@
+"""Add display version
+
+Revision ID: 5a2c7e1d9b34
+Revises: cf969f1ba7c1
+Create Date: 2026-10-19 09:12:44.104512
+
+"""
+from typing import Sequence, Union
+
+import sqlmodel
+from alembic import op
+import sqlalchemy as sa
+
+
+# revision identifiers, used by Alembic.
+revision: str = '5a2c7e1d9b34'
+down_revision: Union[str, None] = 'cf969f1ba7c1'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+
+def upgrade() -> None:
+    op.add_column('display', sa.Column('version', sa.Integer(), nullable=False, server_default='1'))
+
+
+def downgrade() -> None:
+    op.drop_column('display', 'version')
@@ -0,0 +1,27 @@
+"""Add display zones
+
+Revision ID: 8d3f6b2a4c17
+Revises: 5a2c7e1d9b34
+Create Date: 2026-10-19 14:27:03.518240
+
+"""
+from typing import Sequence, Union
+
+import sqlmodel
+from alembic import op
+import sqlalchemy as sa
+
+
+# revision identifiers, used by Alembic.
+revision: str = '8d3f6b2a4c17'
+down_revision: Union[str, None] = '5a2c7e1d9b34'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+
+def upgrade() -> None:
+    op.add_column('display', sa.Column('zones', sa.JSON(), nullable=True))
+
+
+def downgrade() -> None:
+    op.drop_column('display', 'zones')